@@ -0,0 +1,242 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+#define NDEBUG
+
+using byte = unsigned char;
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "include/lico.h"
+#include "include/h_service.h"
+
+
+struct CPUTimer
+{
+  timeval beg, end;
+  CPUTimer() {}
+  ~CPUTimer() {}
+  void start() {gettimeofday(&beg, NULL);}
+  double stop() {gettimeofday(&end, NULL); return end.tv_sec - beg.tv_sec + (end.tv_usec - beg.tv_usec) / 1000000.0;}
+};
+
+
+// absolute version of a path because the daemon resolves it in its own working directory
+static std::string h_absolute(const char* const path)
+{
+  if (path[0] == '/') return path;
+  char cwd [4096];
+  if (getcwd(cwd, sizeof(cwd)) == nullptr) return path;
+  return std::string(cwd) + "/" + path;
+}
+
+
+// send a request for the named files over a connection to the daemon and return the result
+static int h_request_files(const char* const name, h_request req, const char* const input, const char* const output, const bool paths, double& hruntime)
+{
+  const int sock = h_connect(name);
+  if (sock < 0) {fprintf(stderr, "ERROR: cannot connect to '%s'\n\n", name); exit(-1);}
+
+  // send the request
+  CPUTimer htimer;
+  htimer.start();
+  bool sent;
+  if (paths) {
+    const std::string in = h_absolute(input), out = h_absolute(output);
+    std::string names = in;
+    names.push_back('\0');
+    names += out;
+    names.push_back('\0');
+    req.paths = names.size();
+    sent = h_send(sock, &req, sizeof(req)) && h_send(sock, names.data(), names.size());
+  } else {
+    int fds [2];
+    fds[0] = open(input, O_RDONLY | O_CLOEXEC);
+    if (fds[0] < 0) {fprintf(stderr, "ERROR: cannot open '%s'\n\n", input); exit(-1);}
+    fds[1] = open(output, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fds[1] < 0) {fprintf(stderr, "ERROR: cannot create '%s'\n\n", output); exit(-1);}
+    sent = h_send_fds(sock, &req, sizeof(req), fds, 2);
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  // wait for the result
+  h_response res;
+  if (!sent || !h_recv(sock, &res, sizeof(res))) {fprintf(stderr, "ERROR: lost connection to '%s'\n\n", name); exit(-1);}
+  hruntime = htimer.stop();
+  close(sock);
+  return res.result;
+}
+
+
+// read a whole file into data and return its size
+static int h_read(const char* const name, std::vector<byte>& data)
+{
+  FILE* const fin = fopen(name, "rb");
+  if (fin == nullptr) {fprintf(stderr, "ERROR: cannot open '%s'\n\n", name); exit(-1);}
+  fseek(fin, 0, SEEK_END);
+  const int size = ftell(fin);  assert(size > 0);
+  fseek(fin, 0, SEEK_SET);
+  data.resize(size);
+  if (fread(data.data(), 1, size, fin) != (size_t)size) {fprintf(stderr, "ERROR: cannot read '%s'\n\n", name); exit(-1);}
+  fclose(fin);
+  return size;
+}
+
+
+// write size bytes to a file
+static void h_write(const char* const name, const byte* const data, const int size)
+{
+  FILE* const fout = fopen(name, "wb");
+  if (fout == nullptr) {fprintf(stderr, "ERROR: cannot create '%s'\n\n", name); exit(-1);}
+  fwrite(data, 1, size, fout);
+  fclose(fout);
+}
+
+
+// send the input over a connection to the daemon (the only way over TCP), receive the output, and return the result
+static int h_request_data(const char* const name, h_request req, const char* const input, const char* const output, double& hruntime)
+{
+  std::vector<byte> data;
+  req.data = h_read(input, data);
+  const int sock = h_connect(name);
+  if (sock < 0) {fprintf(stderr, "ERROR: cannot connect to '%s'\n\n", name); exit(-1);}
+
+  // send the request and the input and wait for the result and the output
+  CPUTimer htimer;
+  htimer.start();
+  h_response res;
+  if (!h_send(sock, &req, sizeof(req)) || !h_send(sock, data.data(), req.data) || !h_recv(sock, &res, sizeof(res))) {fprintf(stderr, "ERROR: lost connection to '%s'\n\n", name); exit(-1);}
+  if (res.result > 0) {
+    data.resize(res.result);
+    if (!h_recv(sock, data.data(), res.result)) {fprintf(stderr, "ERROR: lost connection to '%s'\n\n", name); exit(-1);}
+  }
+  hruntime = htimer.stop();
+  close(sock);
+
+  if (res.result > 0) h_write(output, data.data(), res.result);
+  return res.result;
+}
+
+
+// place the input into a slot of a shared-memory ring, let the daemon write the output into the same slot, and return the result
+static int h_request_shared(const char* const name, const h_request& req, const char* const input, const char* const output, double& hruntime)
+{
+  // read input file
+  std::vector<byte> data;
+  const int insize = h_read(input, data);
+
+  // size the slot
+  int outcap;
+  if (req.op == h_service_compress) {
+    outcap = lico_compress_bound(insize, &req.params);
+  } else {
+    lico_frame_info info;
+    const int res = lico_get_frame_info(data.data(), insize, &info);
+    outcap = (res < 0) ? res : info.size;
+  }
+  if (outcap < 0) return outcap;
+  h_ring ring;
+  if (!h_ring_attach(name, 1, insize, outcap, ring)) {fprintf(stderr, "ERROR: cannot attach shared memory to '%s'\n\n", name); exit(-1);}
+  memcpy(h_ring_input(ring.head, ring.incap, ring.outcap, 0), data.data(), insize);
+
+  // post the request and wait for the result
+  CPUTimer htimer;
+  htimer.start();
+  h_ring_post(ring, 0, req.op, insize, &req.params);
+  const int result = h_ring_wait(ring, 0);
+  hruntime = htimer.stop();
+
+  // write to file
+  if (result > 0) h_write(output, h_ring_output(ring.head, ring.incap, ring.outcap, 0), result);
+  h_ring_detach(ring);
+  return result;
+}
+
+
+int main(int argc, char* argv [])
+{
+  printf("LICO client 1.0\n");
+  printf("Copyright 2023 Texas State University\n\n");
+
+  if ((argc < 5) || ((strcmp(argv[2], "c") != 0) && (strcmp(argv[2], "d") != 0))) {printf("USAGE: %s socket_path_or_tcp:PORT c|d input_file_name output_file_name [level(-%d to -%d)] [paths(p)] [shared_memory(s)] [performance_analysis(y)]\n\n", argv[0], LICO_MIN_LEVEL, LICO_MAX_LEVEL);  exit(-1);}
+
+  // check remaining arguments for a level, "p" to send the file names instead of descriptors, "s" to pass the data in shared memory, and "y" to enable performance analysis
+  h_request req;
+  memset(&req, 0, sizeof(req));
+  req.op = (argv[2][0] == 'c') ? h_service_compress : h_service_decompress;
+  const bool tcp = (strncmp(argv[1], "tcp:", 4) == 0);  // neither descriptors nor file names can be passed over TCP, so the data is sent inline
+  bool paths = false;
+  bool shared = false;
+  bool perf = false;
+  int level;
+  for (int i = 5; i < argc; i++) {
+    if (strcmp(argv[i], "p") == 0) {
+      paths = true;
+    } else if (strcmp(argv[i], "s") == 0) {
+      shared = true;
+    } else if (strcmp(argv[i], "y") == 0) {
+      perf = true;
+    } else if ((req.op == h_service_compress) && (sscanf(argv[i], "-%d", &level) == 1) && (level >= LICO_MIN_LEVEL) && (level <= LICO_MAX_LEVEL)) {
+      req.params.level = level;
+    } else {
+      printf("Invalid argument '%s'. Use a level from -%d to -%d, 'p' to send file names, 's' to use shared memory, and/or 'y' for performance analysis.\n", argv[i], LICO_MIN_LEVEL, LICO_MAX_LEVEL);
+      exit(-1);
+    }
+  }
+
+  // run the request
+  double hruntime;
+  if (tcp && (paths || shared)) {fprintf(stderr, "ERROR: file names and shared memory require a Unix socket\n\n"); exit(-1);}
+  const int result = shared ? h_request_shared(argv[1], req, argv[3], argv[4], hruntime) : (tcp ? h_request_data(argv[1], req, argv[3], argv[4], hruntime) : h_request_files(argv[1], req, argv[3], argv[4], paths, hruntime));
+  if (result < 0) {fprintf(stderr, "ERROR: %s\n\n", lico_error_name(result)); exit(-1);}
+  printf("%s size: %d bytes\n", (req.op == h_service_compress) ? "encoded" : "decoded", result);
+  if (perf) {
+    printf("request time: %.6f s\n", hruntime);
+  }
+
+  return 0;
+}
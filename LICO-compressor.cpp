@@ -41,17 +41,12 @@ Sponsor: This code is based upon work supported by the U.S. Department of Energy
 
 using byte = unsigned char;
 
-static const int CS = 1024 * 16;  // chunk size (in bytes) [must be multiple of 8]
-
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
 #include <cassert>
-#include <algorithm>
 #include <sys/time.h>
-#include "include/h_BMP_BIT.h"
-#include "include/h_ZERE_1.h"
-#include "include/h_ZERE_4.h"
+#include "include/lico.h"
 
 
 struct CPUTimer
@@ -64,64 +59,71 @@ struct CPUTimer
 };
 
 
-static void h_encode(const byte* const __restrict__ input, const int insize, byte* const __restrict__ output, int& outsize)
+static const char* const formats [] = {"gray8", "rgb24", "bgr24", "rgba32", "bgra32", "gray16", "rgb48", "bgr48", "rgba64"};  // pixel format names
+static const char* const modes [] = {"auto", "float field", "multi-band image", "volume", "records", "pixels", "stored without a transform", "BMP image", "Netpbm image", "TIFF image"};  // mode names
+
+
+// parse a multi-band image description of the form WIDTHxHEIGHTxBANDS[:16][:planar][:rBAND]
+static bool h_parse_msi(const char* const arg, lico_params& p)
 {
-  // initialize
-  const int chunks = (insize + CS - 1) / CS;  // round up
-  int* const head_out = (int*)output;
-  unsigned short* const size_out = (unsigned short*)&head_out[1];
-  byte* const data_out = (byte*)&size_out[chunks];
-  int* const carry = new int [chunks];
-  memset(carry, 0, chunks * sizeof(int));
-
-  // process chunks in parallel
-  #pragma omp parallel for schedule(dynamic, 1)
-  for (int chunkID = 0; chunkID < chunks; chunkID++) {
-    // load chunk
-    long long chunk1 [CS / sizeof(long long)];
-    long long chunk2 [CS / sizeof(long long)];
-    byte* in = (byte*)chunk1;
-    byte* out = (byte*)chunk2;
-    const int base = chunkID * CS;
-    const int osize = std::min(CS, insize - base);
-    memcpy(out, &input[base], osize);
-    
-    // encode chunk
-    int csize = osize;
-    bool good = h_ZERE_4(csize, out, in);
-    if (good) {
-      good = h_ZERE_1(csize, in, out);
-    }
-        
-    int offs = 0;
-    if (chunkID > 0) {
-      do {
-        #pragma omp atomic read
-        offs = carry[chunkID - 1];
-      } while (offs == 0);
-      #pragma omp flush
+  int len = 0;
+  if (sscanf(arg, "%dx%dx%d%n", &p.width, &p.height, &p.depth, &len) != 3) return false;
+  p.bytes = 1;
+  p.planar = 0;
+  p.ref = LICO_REF_PREV;
+  const char* opt = &arg[len];
+  while (*opt == ':') {
+    opt++;
+    len = 0;
+    if (strncmp(opt, "16", 2) == 0) {
+      p.bytes = 2;
+      len = 2;
+    } else if (strncmp(opt, "planar", 6) == 0) {
+      p.planar = 1;
+      len = 6;
+    } else if ((opt[0] == 'r') && (sscanf(&opt[1], "%d%n", &p.ref, &len) == 1)) {
+      len++;
     }
-    if (good && (csize < osize)) {
-      // store compressed data
-      #pragma omp atomic write
-      carry[chunkID] = offs + csize;
-      size_out[chunkID] = csize;
-      memcpy(&data_out[offs], out, csize);
-    } else {
-      // store original data
-      #pragma omp atomic write
-      carry[chunkID] = offs + osize;
-      size_out[chunkID] = osize;
-      memcpy(&data_out[offs], &input[base], osize);
+    if (len == 0) return false;
+    opt += len;
+  }
+  return (*opt == 0);
+}
+
+
+// parse a volume description of the form WIDTHxHEIGHTxDEPTH[:16][:sSLAB]
+static bool h_parse_vol(const char* const arg, lico_params& p)
+{
+  int len = 0;
+  if (sscanf(arg, "%dx%dx%d%n", &p.width, &p.height, &p.depth, &len) != 3) return false;
+  p.bytes = 1;
+  p.slab = 0;
+  const char* opt = &arg[len];
+  while (*opt == ':') {
+    opt++;
+    len = 0;
+    if (strncmp(opt, "16", 2) == 0) {
+      p.bytes = 2;
+      len = 2;
+    } else if ((opt[0] == 's') && (sscanf(&opt[1], "%d%n", &p.slab, &len) == 1)) {
+      len++;
     }
+    if (len == 0) return false;
+    opt += len;
   }
+  return (*opt == 0);
+}
 
-  // output header
-  head_out[0] = insize;
 
-  // finish
-  outsize = &data_out[carry[chunks - 1]] - output;
-  delete [] carry;
+// parse a pixel buffer description of the form WIDTHxHEIGHT:FORMAT
+static bool h_parse_raw(const char* const arg, lico_params& p)
+{
+  int len = 0;
+  if ((sscanf(arg, "%dx%d%n", &p.width, &p.height, &len) != 2) || (arg[len] != ':')) return false;
+  for (p.format = 0; p.format < (int)(sizeof(formats) / sizeof(formats[0])); p.format++) {
+    if (strcmp(&arg[len + 1], formats[p.format]) == 0) return true;
+  }
+  return false;
 }
 
 
@@ -131,7 +133,7 @@ int main(int argc, char* argv [])
   printf("Copyright 2023 Texas State University\n\n");
 
   // read input from file
-  if (argc < 3) {printf("USAGE: %s input_file_name compressed_file_name [performance_analysis(y)]\n\n", argv[0]);  exit(-1);}
+  if (argc < 3) {printf("USAGE: %s input_file_name compressed_file_name [level(-%d to -%d)] [float_field(-f WIDTHxHEIGHT)] [multi_band(-m WIDTHxHEIGHTxBANDS[:16][:planar][:rBAND])] [volume(-v WIDTHxHEIGHTxDEPTH[:16][:sSLAB])] [records(-s auto|STRIDE[:WIDTH])] [pixels(-r WIDTHxHEIGHT:FORMAT)] [chunk_size(-c 4|8|16|32|64)] [performance_analysis(y)]\n\n", argv[0], LICO_MIN_LEVEL, LICO_MAX_LEVEL);  exit(-1);}
   FILE* const fin = fopen(argv[1], "rb");  
   fseek(fin, 0, SEEK_END);
   const int fsize = ftell(fin);  assert(fsize > 0);
@@ -141,32 +143,56 @@ int main(int argc, char* argv [])
   fclose(fin);
   printf("original size: %d bytes\n", insize);
  
-  // check if third argument is "y" to enable performance analysis
-  char* perf_str = argv[3];
+  // check remaining arguments for a compression level, a float field, multi-band image, volume, record layout, pixel format, or chunk size, and "y" to enable performance analysis
+  lico_params p;
+  memset(&p, 0, sizeof(p));
+  p.level = LICO_DEFAULT_LEVEL;
+  p.mode = LICO_MODE_AUTO;
   bool perf = false;
-  if ((perf_str != nullptr) && (strcmp(perf_str, "y") == 0)) {
-    perf = true;
-  } else if ((perf_str != nullptr) && (strcmp(perf_str, "y") != 0)) {
-    printf("Invalid performance analysis argument. Use 'y' or leave it empty.\n");
-    exit(-1);
+  for (int i = 3; i < argc; i++) {
+    if (strcmp(argv[i], "y") == 0) {
+      perf = true;
+    } else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc) && (sscanf(argv[i + 1], "%dx%d", &p.width, &p.height) == 2)) {
+      p.mode = LICO_MODE_F32;
+      i++;
+    } else if ((strcmp(argv[i], "-m") == 0) && (i + 1 < argc) && h_parse_msi(argv[i + 1], p)) {
+      p.mode = LICO_MODE_MSI;
+      i++;
+    } else if ((strcmp(argv[i], "-v") == 0) && (i + 1 < argc) && h_parse_vol(argv[i + 1], p)) {
+      p.mode = LICO_MODE_VOL;
+      i++;
+    } else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc) && ((strcmp(argv[i + 1], "auto") == 0) || (sscanf(argv[i + 1], "%d:%d", &p.stride, &p.element) >= 1))) {
+      p.mode = LICO_MODE_STR;
+      i++;
+    } else if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc) && h_parse_raw(argv[i + 1], p)) {
+      p.mode = LICO_MODE_RAW;
+      i++;
+    } else if ((strcmp(argv[i], "-c") == 0) && (i + 1 < argc) && (sscanf(argv[i + 1], "%d", &p.chunk) == 1)) {
+      i++;
+    } else if ((argv[i][0] == '-') && (argv[i][1] >= '0' + LICO_MIN_LEVEL) && (argv[i][1] <= '0' + LICO_MAX_LEVEL) && (argv[i][2] == 0)) {
+      p.level = argv[i][1] - '0';
+    } else {
+      printf("Invalid argument '%s'. Use a level from -%d to -%d, '-f WIDTHxHEIGHT' for a field of floats, '-m WIDTHxHEIGHTxBANDS[:16][:planar][:rBAND]' for a multi-band image, '-v WIDTHxHEIGHTxDEPTH[:16][:sSLAB]' for a volume, '-s auto|STRIDE[:WIDTH]' for fixed-size records, '-r WIDTHxHEIGHT:FORMAT' for raw pixels (gray8, rgb24, bgr24, rgba32, bgra32, gray16, rgb48, bgr48, rgba64), '-c KB' for a chunk size of 4, 8, 16, 32, or 64 kB, and/or 'y' for performance analysis.\n", argv[i], LICO_MIN_LEVEL, LICO_MAX_LEVEL);
+      exit(-1);
+    }
   }
+  printf("level: %d\n", p.level);
 
   // allocate CPU memory
-  const int chunks = (insize + CS - 1) / CS;  // round up
-  const int maxsize = 3 * sizeof(int) + chunks * sizeof(short) + chunks * CS;
+  const int maxsize = lico_compress_bound(insize, &p);
+  if (maxsize < 0) {fprintf(stderr, "ERROR: %s\n\n", lico_error_name(maxsize)); exit(-1);}
   byte* const hencoded = new byte [maxsize];
-  int hencsize = 0; 
 
-  // time CPU preprocessor encoding
-  byte* hpreencdata = new byte [insize];
-  std::copy(input, input + insize, hpreencdata);
-  int hpreencsize = insize;
+  // time CPU encoding
   CPUTimer htimer;
   htimer.start();
-  h_BMP_BIT(hpreencsize, hpreencdata);
-  h_encode(hpreencdata, hpreencsize, hencoded, hencsize);
+  const int hencsize = lico_compress_params(input, insize, hencoded, maxsize, &p);
   double hruntime = htimer.stop();
+  if (hencsize < 0) {fprintf(stderr, "ERROR: %s\n\n", lico_error_name(hencsize)); exit(-1);}
 
+  // report how the input was compressed (inputs that do not fit the requested or detected format are stored without a transform)
+  lico_frame_info info;
+  if (lico_get_frame_info(hencoded, hencsize, &info) == 0) printf("mode: %s\n", modes[info.mode]);
   printf("encoded size: %d bytes\n", hencsize); 
   const float CR = (100.0 * hencsize) / insize;
   printf("ratio: %6.2f%% %7.3fx\n", CR, 100.0 / CR);  
@@ -0,0 +1,357 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+#define NDEBUG
+
+using byte = unsigned char;
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <csignal>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "include/lico.h"
+#include "include/h_service.h"
+
+
+// input file that is mapped if possible and read into a buffer otherwise
+struct h_input
+{
+  const byte* data;
+  int size;
+  void* map;
+  h_input() : data(nullptr), size(0), map(MAP_FAILED) {}
+  ~h_input() {if (map != MAP_FAILED) munmap(map, size);}
+};
+
+
+// load the input from fd and return whether it holds between 1 byte and 2 GB
+static bool h_load(const int fd, std::vector<byte>& buf, h_input& in)
+{
+  struct stat st;
+  if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode)) {
+    if ((st.st_size < 1) || (st.st_size > 0x7fffffff)) return false;
+    in.map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (in.map != MAP_FAILED) {
+      in.data = (const byte*)in.map;
+      in.size = st.st_size;
+      return true;
+    }
+  }
+
+  // pipes and other streams
+  long long size = 0;
+  while (true) {
+    if ((long long)buf.size() < size + 65536) buf.resize(std::min(2 * buf.size() + 65536, (size_t)0x7fffffff));
+    const ssize_t n = read(fd, &buf[size], buf.size() - size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) return false;
+    if (n == 0) break;
+    size += n;
+    if (size >= 0x7fffffff) return false;
+  }
+  in.data = buf.data();
+  in.size = size;
+  return (size > 0);
+}
+
+
+// write size bytes to fd and return whether they were written
+static bool h_store(const int fd, const byte* const data, const int size)
+{
+  int done = 0;
+  while (done < size) {
+    const ssize_t n = write(fd, &data[done], size - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+
+// run one request on the size bytes at data with the executor, leaving the output in the grow-only buffer out, and return the result
+static int h_run(LICO_Executor* const ex, const h_request& req, const byte* const data, const int size, std::vector<byte>& out)
+{
+  // size the output
+  int cap;
+  if (req.op == h_service_compress) {
+    cap = lico_compress_bound(size, &req.params);
+  } else {
+    lico_frame_info info;
+    const int res = lico_get_frame_info(data, size, &info);
+    cap = (res < 0) ? res : info.size;
+  }
+  if (cap < 0) return cap;
+  if ((int)out.size() < cap) out.resize(cap);
+
+  // run on the warm threads and contexts of the executor
+  LICO_Job* const job = (req.op == h_service_compress) ? lico_submit_compress(ex, data, size, out.data(), cap, &req.params, nullptr, nullptr) : lico_submit_decompress(ex, data, size, out.data(), cap, nullptr, nullptr);
+  if (job == nullptr) return LICO_ERROR_CAPACITY;
+  return lico_job_wait(job);
+}
+
+
+// run one request on files with the buffers of the connection and return the result
+static int h_process(LICO_Executor* const ex, const h_request& req, const int fdin, const int fdout, std::vector<byte>& inbuf, std::vector<byte>& outbuf)
+{
+  h_input in;
+  if ((fdin < 0) || (fdout < 0) || !h_load(fdin, inbuf, in)) return LICO_ERROR_ARGUMENT;
+  const int result = h_run(ex, req, in.data, in.size, outbuf);
+  if ((result > 0) && !h_store(fdout, outbuf.data(), result)) return LICO_ERROR_ARGUMENT;
+  return result;
+}
+
+
+// whether the peer of a Unix socket runs as the user of the daemon (only such clients may have the daemon open files by name)
+static bool h_owner(const int conn)
+{
+  ucred cred;
+  socklen_t len = sizeof(cred);
+  return (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0) && (cred.uid == geteuid());
+}
+
+
+// daemon end of a shared-memory ring
+struct h_ring_server
+{
+  h_ring_head* head;  // mapped ring
+  std::atomic<int> pending;  // callbacks that have not returned yet
+};
+
+
+// ticket of a request taken from a slot
+struct h_ticket
+{
+  h_ring_server* ring;
+  h_slot* slot;
+};
+
+
+// hand the result of a request back to the client that posted it
+static void h_complete(const int result, void* const user)
+{
+  h_ticket* const t = (h_ticket*)user;
+  h_ring_server* const ring = t->ring;
+  t->slot->result = result;
+  __atomic_store_n(&t->slot->state, h_slot_done, __ATOMIC_RELEASE);
+  h_futex_wake(&t->slot->state);
+  ring->pending.fetch_sub(1, std::memory_order_release);
+}
+
+
+// run the requests that the client posts in the ring until it disconnects (the data stays in the ring, which the library reads and writes directly)
+static void h_serve_ring(const int conn, LICO_Executor* const ex, const int fd)
+{
+  // map and check the ring
+  h_response res;
+  res.result = LICO_ERROR_ARGUMENT;
+  struct stat st;
+  h_ring_server ring;
+  ring.head = nullptr;
+  ring.pending.store(0);
+  long long bytes = 0;
+  int slots = 0, incap = 0, outcap = 0;
+  const int seals = (fd >= 0) ? fcntl(fd, F_GET_SEALS) : -1;
+  if ((seals >= 0) && ((seals & h_ring_seals) == h_ring_seals) && (fstat(fd, &st) == 0) && (st.st_size >= (long long)sizeof(h_ring_head))) {
+    // the sealed size cannot change, so the mapping stays valid however the client treats the memfd
+    void* const mem = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem != MAP_FAILED) {
+      ring.head = (h_ring_head*)mem;
+      bytes = st.st_size;
+      const int magic = __atomic_load_n(&ring.head->magic, __ATOMIC_RELAXED);
+      slots = __atomic_load_n(&ring.head->slots, __ATOMIC_RELAXED);
+      incap = __atomic_load_n(&ring.head->incap, __ATOMIC_RELAXED);
+      outcap = __atomic_load_n(&ring.head->outcap, __ATOMIC_RELAXED);
+      const long long need = h_ring_bytes(slots, incap, outcap);
+      if ((magic == h_ring_magic) && (need > 0) && (need <= bytes)) res.result = 0;
+    }
+  }
+  if (fd >= 0) close(fd);
+  if (!h_send(conn, &res, sizeof(res)) || (res.result != 0)) {
+    if (ring.head != nullptr) munmap(ring.head, bytes);
+    return;
+  }
+
+  // the slots are located with the geometry that was checked above, so the client cannot move them by changing the header
+  h_ring_head* const head = ring.head;
+  std::vector<LICO_Job*> jobs(slots, nullptr);
+  std::vector<h_ticket> tickets(slots);
+  for (int s = 0; s < slots; s++) tickets[s] = {&ring, h_ring_slot(head, incap, outcap, s)};
+
+  while (true) {
+    const int bell = __atomic_load_n(&head->doorbell, __ATOMIC_ACQUIRE);
+    for (int s = 0; s < slots; s++) {
+      // release finished jobs (the client can only post to a slot again after its job is done)
+      if ((jobs[s] != nullptr) && lico_job_done(jobs[s])) {
+        lico_job_wait(jobs[s]);
+        jobs[s] = nullptr;
+      }
+      h_slot* const slot = tickets[s].slot;
+      int state = h_slot_posted;
+      if ((jobs[s] == nullptr) && __atomic_compare_exchange_n(&slot->state, &state, h_slot_busy, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        const int op = slot->op;
+        const int size = slot->size;
+        ring.pending.fetch_add(1, std::memory_order_relaxed);
+        if ((size >= 1) && (size <= incap) && ((op == h_service_compress) || (op == h_service_decompress))) {
+          byte* const in = h_ring_input(head, incap, outcap, s);
+          byte* const out = h_ring_output(head, incap, outcap, s);
+          jobs[s] = (op == h_service_compress) ? lico_submit_compress(ex, in, size, out, outcap, &slot->params, h_complete, &tickets[s]) : lico_submit_decompress(ex, in, size, out, outcap, h_complete, &tickets[s]);
+          if (jobs[s] == nullptr) h_complete(LICO_ERROR_CAPACITY, &tickets[s]);
+        } else {
+          h_complete(LICO_ERROR_ARGUMENT, &tickets[s]);
+        }
+      }
+    }
+
+    // sleep until the client posts a request or disconnects
+    pollfd pfd = {conn, POLLIN, 0};
+    if (poll(&pfd, 1, 0) != 0) break;
+    h_futex_wait(&head->doorbell, bell, 100);
+  }
+
+  // finish the running requests before releasing the ring
+  for (int s = 0; s < slots; s++) {
+    if (jobs[s] != nullptr) lico_job_wait(jobs[s]);
+  }
+  while (ring.pending.load(std::memory_order_acquire) > 0) usleep(100);
+  munmap(head, bytes);
+}
+
+
+// answer the requests of one client until it disconnects (TCP clients can only send their data inline)
+static void h_serve(const int conn, LICO_Executor* const ex, const bool tcp)
+{
+  std::vector<byte> inbuf, outbuf;  // grow-only buffers of this connection
+  h_request req;
+  int fds [2];
+  while (h_recv_fds(conn, &req, sizeof(req), fds)) {
+    if (req.op == h_service_attach) {
+      // the connection now belongs to the ring
+      if (fds[1] >= 0) close(fds[1]);
+      h_serve_ring(conn, ex, fds[0]);
+      break;
+    }
+    if ((req.paths < 0) || (req.paths > 8192) || (req.data < 0) || ((req.paths > 0) && (req.data > 0))) break;  // the rest of the stream cannot be interpreted
+    bool valid = (req.op == h_service_compress) || (req.op == h_service_decompress);
+    h_response res;
+    if (req.data > 0) {
+      // input and output pass through the connection
+      valid = valid && (fds[0] < 0) && (fds[1] < 0);
+      if (fds[0] >= 0) close(fds[0]);
+      if (fds[1] >= 0) close(fds[1]);
+      if ((int)inbuf.size() < req.data) inbuf.resize(req.data);
+      if (!h_recv(conn, inbuf.data(), req.data)) break;
+      res.result = valid ? h_run(ex, req, inbuf.data(), req.data, outbuf) : LICO_ERROR_ARGUMENT;
+      if (!h_send(conn, &res, sizeof(res)) || ((res.result > 0) && !h_send(conn, outbuf.data(), res.result))) break;
+      continue;
+    }
+    if (req.paths > 0) {
+      // open the named files (the daemon opens them with its own permissions, so only its own user may name them, and not over TCP)
+      std::vector<char> paths(req.paths + 1, 0);
+      if (!h_recv(conn, paths.data(), req.paths)) break;
+      const int len = strlen(paths.data());
+      valid = valid && !tcp && h_owner(conn) && (len + 1 < req.paths) && (fds[0] < 0) && (fds[1] < 0);
+      if (valid) {
+        fds[0] = open(paths.data(), O_RDONLY | O_CLOEXEC);
+        fds[1] = open(&paths[len + 1], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      }
+    }
+    res.result = valid ? h_process(ex, req, fds[0], fds[1], inbuf, outbuf) : LICO_ERROR_ARGUMENT;
+    if (fds[0] >= 0) close(fds[0]);
+    if (fds[1] >= 0) close(fds[1]);
+    if (!h_send(conn, &res, sizeof(res))) break;
+  }
+  close(conn);
+}
+
+
+int main(int argc, char* argv [])
+{
+  printf("LICO daemon 1.0\n");
+  printf("Copyright 2023 Texas State University\n\n");
+
+  if ((argc < 2) || (argc > 3)) {printf("USAGE: %s socket_path_or_tcp:PORT [threads]\n\n", argv[0]);  exit(-1);}
+  const int threads = (argc > 2) ? atoi(argv[2]) : 0;
+
+  // listen on the socket
+  sockaddr_storage addr;
+  const socklen_t len = h_address(argv[1], addr);
+  if (len == 0) {fprintf(stderr, "ERROR: invalid address '%s'\n\n", argv[1]); exit(-1);}
+  const bool tcp = (addr.ss_family != AF_UNIX);
+  const int sock = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (!tcp) {
+    unlink(((sockaddr_un*)&addr)->sun_path);  // remove a stale socket
+  } else {
+    const int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  }
+  const mode_t mask = umask(0177);  // only the daemon's user may connect to the Unix socket
+  const bool bound = (sock >= 0) && (bind(sock, (sockaddr*)&addr, len) == 0);
+  umask(mask);
+  if (!bound || (listen(sock, 64) != 0)) {fprintf(stderr, "ERROR: cannot listen on '%s': %s\n\n", argv[1], strerror(errno)); exit(-1);}
+  signal(SIGPIPE, SIG_IGN);
+
+  // keep the thread team and scratch space warm across all requests
+  LICO_Executor* const ex = lico_create_executor(threads);
+  if (ex == nullptr) {fprintf(stderr, "ERROR: cannot create executor\n\n"); exit(-1);}
+  printf("listening on %s\n", argv[1]);
+  fflush(stdout);
+
+  // serve every client on its own thread
+  while (true) {
+    const int conn = accept4(sock, nullptr, nullptr, SOCK_CLOEXEC);
+    if (conn < 0) {
+      if ((errno == EINTR) || (errno == ECONNABORTED)) continue;
+      fprintf(stderr, "ERROR: accept failed: %s\n\n", strerror(errno));
+      exit(-1);
+    }
+    std::thread(h_serve, conn, ex, tcp).detach();
+  }
+
+  return 0;
+}
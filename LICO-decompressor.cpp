@@ -41,17 +41,12 @@ Sponsor: This code is based upon work supported by the U.S. Department of Energy
 
 using byte = unsigned char;
 
-static const int CS = 1024 * 16;  // chunk size (in bytes) [must be multiple of 8]
-
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
 #include <cassert>
-#include <algorithm>
 #include <sys/time.h>
-#include "include/h_BMP_BIT.h"
-#include "include/h_ZERE_1.h"
-#include "include/h_ZERE_4.h"
+#include "include/lico.h"
 
 
 struct CPUTimer
@@ -64,97 +59,53 @@ struct CPUTimer
 };
 
 
-static void h_decode(const byte* const __restrict__ input, byte* const __restrict__ output, int& outsize)
-{
-  // input header
-  int* const head_in = (int*)input;
-  outsize = head_in[0];
-
-  // initialize
-  const int chunks = (outsize + CS - 1) / CS;  // round up
-  unsigned short* const size_in = (unsigned short*)&head_in[1];
-  byte* const data_in = (byte*)&size_in[chunks];
-  int* const start = new int [chunks];
-
-  // convert chunk sizes into starting positions
-  int pfs = 0;
-  for (int chunkID = 0; chunkID < chunks; chunkID++) {
-    start[chunkID] = pfs;
-    pfs += (int)size_in[chunkID];
-  }
-
-  // process chunks in parallel
-  #pragma omp parallel for schedule(dynamic, 1)
-  for (int chunkID = 0; chunkID < chunks; chunkID++) {
-    // load chunk
-    long long chunk1 [CS / sizeof(long long)];
-    long long chunk2 [CS / sizeof(long long)];
-    byte* in = (byte*)chunk1;
-    byte* out = (byte*)chunk2;
-    const int base = chunkID * CS;
-    const int osize = std::min(CS, outsize - base);
-    int csize = size_in[chunkID];
-    if (csize == osize) {
-      // simply copy
-      memcpy(&output[base], &data_in[start[chunkID]], osize);
-    } else {
-      // decompress
-      memcpy(out, &data_in[start[chunkID]], csize);
-
-      // decode
-      h_iZERE_1(csize, out, in);
-      h_iZERE_4(csize, in, out);
-
-      if (csize != osize) {fprintf(stderr, "ERROR: csize %d does not match osize %d\n\n", csize, osize); exit(-1);}
-      memcpy(&output[base], out, csize);
-    }
-  }
-
-  delete [] start;
-}
-
-
 int main(int argc, char* argv [])
 {
   printf("LICO decompressor 1.0\n");
   printf("Copyright 2023 Texas State University\n\n");
 
   // read input from file
-  if (argc < 3) {printf("USAGE: %s compressed_file_name decompressed_file_name [performance_analysis (y)]\n\n", argv[0]);  exit(-1);}
+  if (argc < 3) {printf("USAGE: %s compressed_file_name decompressed_file_name [slice_range(-z FIRST:LAST)] [performance_analysis (y)]\n\n", argv[0]);  exit(-1);}
 
   // read input file
   FILE* const fin = fopen(argv[1], "rb");
-  int pre_size = 0;
-  const int pre_val = fread(&pre_size, sizeof(pre_size), 1, fin); assert(pre_val == sizeof(pre_size));
   fseek(fin, 0, SEEK_END);
   const int hencsize = ftell(fin);  assert(hencsize > 0);
-  byte* const hencoded = new byte [pre_size];
+  byte* const hencoded = new byte [hencsize];
   fseek(fin, 0, SEEK_SET);
   const int insize = fread(hencoded, 1, hencsize, fin);  assert(insize == hencsize);
   fclose(fin);
   printf("encoded size: %d bytes\n", insize);
 
-  // check if third argument is "y" to enable performance analysis
-  char* perf_str = argv[3];
+  // check remaining arguments for a slice range of a volume and "y" to enable performance analysis
   bool perf = false;
-  if ((perf_str != nullptr) && (strcmp(perf_str, "y") == 0)) {
-    perf = true;
-  } else if ((perf_str != nullptr) && (strcmp(perf_str, "y") != 0)) {
-    printf("Invalid performance analysis argument. Use 'y' or leave it empty.\n");
-    exit(-1);
+  int z0 = -1, z1 = -1;
+  for (int i = 3; i < argc; i++) {
+    if (strcmp(argv[i], "y") == 0) {
+      perf = true;
+    } else if ((strcmp(argv[i], "-z") == 0) && (i + 1 < argc) && (sscanf(argv[i + 1], "%d:%d", &z0, &z1) == 2)) {
+      i++;
+    } else {
+      printf("Invalid argument '%s'. Use '-z FIRST:LAST' to decode only slices FIRST to LAST of a volume and/or 'y' for performance analysis.\n", argv[i]);
+      exit(-1);
+    }
   }
 
   // allocate CPU memory
-  byte* hdecoded = new byte [pre_size];
-  int hdecsize = 0;
+  lico_frame_info info;
+  const int res = lico_get_frame_info(hencoded, insize, &info);
+  if (res < 0) {fprintf(stderr, "ERROR: %s\n\n", lico_error_name(res)); exit(-1);}
+  byte* const hdecoded = new byte [info.size];
 
   // time CPU decoding
   CPUTimer htimer;
   htimer.start();
-  h_decode(hencoded, hdecoded, hdecsize);
-  h_iBMP_BIT(hdecsize, hdecoded);
+  const int hdecsize = (z0 >= 0) ? lico_decompress_slices(hencoded, insize, z0, z1 + 1, hdecoded, info.size) : lico_decompress(hencoded, insize, hdecoded, info.size);
   double hruntime = htimer.stop();
+  if (hdecsize == LICO_ERROR_MODE) {fprintf(stderr, "ERROR: slices %d to %d are not part of a compressed volume\n\n", z0, z1); exit(-1);}
+  if (hdecsize < 0) {fprintf(stderr, "ERROR: %s\n\n", lico_error_name(hdecsize)); exit(-1);}
 
+  printf("level: %d\n", info.level);
   printf("decoded size: %d bytes\n", hdecsize);
   const float CR = (100.0 * insize) / hdecsize;
   printf("ratio: %6.2f%% %7.3fx\n", CR, 100.0 / CR);
@@ -37,10 +37,15 @@ Sponsor: This code is based upon work supported by the U.S. Department of Energy
 */
 
 
+
 #ifndef bmp_bit
 #define bmp_bit
 
 
+#include "h_levels.h"
+#include "h_arena.h"
+
+
 static inline int h_BMP_BIT_get2(const byte data [])
 {
   int ret = data[1];
@@ -75,246 +80,670 @@ static inline void h_BMP_BIT_set4(byte data [], const int val)
 }
 
 
-static inline void h_BMP_BIT(int& size, byte*& data)
+// load and store a native-order value of type T at any byte offset (the pixel array of a file need not be aligned for T)
+template <typename T>
+static inline T h_BMP_BIT_load(const byte* const p)
 {
-  assert(sizeof(unsigned long long) == 8);
+  T val;
+  memcpy(&val, p, sizeof(T));
+  return val;
+}
 
-  if (size < 54) {
-    printf("h_BMP_BIT: WARNING file size is too small for a BMP image\n");
-  } else {
-    const int w = h_BMP_BIT_get4(&data[18]);
-    const int h = h_BMP_BIT_get4(&data[22]);
-    const int pad = ((w * 3 + 3) & ~3) - (w * 3);
-    const int width = w * 3 + pad;
-    if ((data[0] != 'B') || (data[1] != 'M') || (h_BMP_BIT_get4(&data[2]) != 54 + h * width) || (h_BMP_BIT_get4(&data[10]) != 54) || (h_BMP_BIT_get4(&data[14]) != 40) || (h_BMP_BIT_get2(&data[26]) != 1) || (h_BMP_BIT_get2(&data[28]) != 24) || (h_BMP_BIT_get4(&data[30]) != 0) || (h_BMP_BIT_get4(&data[34]) != h * width) || (h_BMP_BIT_get4(&data[46]) != 0) || (h_BMP_BIT_get4(&data[50]) != 0) || (size != 54 + h * width) || (w < 1) || (h < 1)) {
-      printf("h_BMP_BIT: WARNING: not a supported BMP format\n");
+
+template <typename T>
+static inline void h_BMP_BIT_store(byte* const p, const T val)
+{
+  memcpy(p, &val, sizeof(T));
+}
+
+
+// read-only view of samples of type T that start at any byte address
+template <typename T>
+struct h_BMP_BIT_samples
+{
+  const byte* p;
+  T operator[](const long long i) const {return h_BMP_BIT_load<T>(&p[i * (long long)sizeof(T)]);}
+};
+
+
+// bytes in a block of a x b x c x d items (all positive) saturated at 2^31, so that the size checks cannot overflow on corrupt geometry
+static inline long long h_BMP_BIT_extent(const int a, const int b, const int c, const int d = 1)
+{
+  const long long lim = 1LL << 31;
+  const long long ab = std::min((long long)a * b, lim);
+  const long long abc = std::min(ab * c, lim);
+  return std::min(abc * d, lim);
+}
+
+
+// TCMS of a channel value with sizeof(T) * 8 bits
+template <typename T>
+static inline unsigned int h_BMP_BIT_TCMS(const unsigned int v)
+{
+  const int bits = sizeof(T) * 8;
+  return ((v << 1) ^ (0 - ((v >> (bits - 1)) & 1))) & (T)~0;
+}
+
+
+template <typename T>
+static inline unsigned int h_BMP_BIT_iTCMS(const unsigned int v)
+{
+  return (v >> 1) ^ (0 - (v & 1));
+}
+
+
+// transpose an 8x8 bit matrix
+static inline unsigned long long h_BMP_BIT_transpose8(unsigned long long x)
+{
+  unsigned long long t;
+  t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+  x = x ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+  x = x ^ t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+  x = x ^ t ^ (t << 28);
+  return x;
+}
+
+
+// transpose a 16x16 or 32x32 bit matrix
+template <typename T>
+static inline void h_BMP_BIT_transpose(T a [sizeof(T) * 8])
+{
+  const int bits = sizeof(T) * 8;
+  T m = (T)~0 >> (bits / 2);
+  for (int j = bits / 2; j != 0; j >>= 1, m ^= m << j) {
+    for (int k = 0; k < bits; k = ((k | j) + 1) & ~j) {
+      const T t = (a[k] ^ (a[k | j] >> j)) & m;
+      a[k] ^= t;
+      a[k | j] ^= t << j;
+    }
+  }
+}
+
+
+// BIT: split num values into sizeof(T) * 8 bit planes (out need not be aligned for T)
+template <typename T>
+static inline void h_BMP_BIT_BIT(const T* const __restrict__ in, const int num, byte* const __restrict__ out)
+{
+  const int bits = sizeof(T) * 8;
+  const int extra = num % bits;
+  const int esize = num - extra;
+  #pragma omp parallel for default(none) shared(in, out, esize, bits)
+  for (int pos = 0; pos < esize; pos += bits) {
+    if constexpr (sizeof(T) == 1) {
+      const unsigned long long x = h_BMP_BIT_transpose8(h_BMP_BIT_load<unsigned long long>((const byte*)&in[pos]));
+      for (int i = 0; i < 8; i++) {
+        out[pos / 8 + i * (esize / 8)] = x >> (i * 8);
+      }
+    } else {
+      T a [bits];
+      for (int i = 0; i < bits; i++) a[i] = in[pos + i];
+      h_BMP_BIT_transpose<T>(a);
+      for (int i = 0; i < bits; i++) {
+        h_BMP_BIT_store<T>(&out[(pos / bits + (long long)i * (esize / bits)) * sizeof(T)], a[i]);
+      }
+    }
+  }
+
+  // copy leftover values
+  for (int i = esize; i < num; i++) {
+    h_BMP_BIT_store<T>(&out[(long long)i * sizeof(T)], in[i]);
+  }
+}
+
+
+// in need not be aligned for T
+template <typename T>
+static inline void h_BMP_BIT_iBIT(const byte* const __restrict__ in, const int num, T* const __restrict__ out)
+{
+  const int bits = sizeof(T) * 8;
+  const int extra = num % bits;
+  const int esize = num - extra;
+  #pragma omp parallel for default(none) shared(in, out, esize, bits)
+  for (int pos = 0; pos < esize; pos += bits) {
+    if constexpr (sizeof(T) == 1) {
+      unsigned long long x = 0;
+      for (int i = 0; i < 8; i++) x |= (unsigned long long)in[pos / 8 + i * (esize / 8)] << (i * 8);
+      h_BMP_BIT_store<unsigned long long>((byte*)&out[pos], h_BMP_BIT_transpose8(x));
     } else {
-      data[0] = data[0] - 'B';  // B
-      data[1] = data[1] - 'M';  // M
-      h_BMP_BIT_set4(&data[2], h_BMP_BIT_get4(&data[2]) - (h * width + 54));  // size in bytes
-      //h_BMP_BIT_set4(&data[6], h_BMP_BIT_get4(&data[6]));  // 2 reserved values (0, 0)
-      h_BMP_BIT_set4(&data[10], h_BMP_BIT_get4(&data[10]) - 54);  // offset to image data (54)
-      h_BMP_BIT_set4(&data[14], h_BMP_BIT_get4(&data[14]) - 40);  // header size (40)
-      //h_BMP_BIT_set4(&data[18], w);  // width
-      //h_BMP_BIT_set4(&data[22], h);  // height
-      h_BMP_BIT_set2(&data[26], h_BMP_BIT_get2(&data[26]) - 1);  // color planes (must be 1)
-      h_BMP_BIT_set2(&data[28], h_BMP_BIT_get2(&data[28]) - 24);  // bits per pixel (only 24 supported)
-      //h_BMP_BIT_set4(&data[30], h_BMP_BIT_get4(&data[30]) - 0);  // compression method (only 0 supported)
-      h_BMP_BIT_set4(&data[34], h_BMP_BIT_get4(&data[34]) - (h * width));  // image size
-      //h_BMP_BIT_set4(&data[38], h_BMP_BIT_get4(&data[38]));  // horizontal resolution
-      h_BMP_BIT_set4(&data[42], h_BMP_BIT_get4(&data[42]) - h_BMP_BIT_get4(&data[38]));  // vertical resolution [same as previous?]
-      //h_BMP_BIT_set4(&data[46], h_BMP_BIT_get4(&data[46]) - 0);  // number of colors or 0
-      //h_BMP_BIT_set4(&data[50], h_BMP_BIT_get4(&data[50]) - 0);  // important colors or 0
-
-      const int newsize = w * h * sizeof(byte);
-      unsigned long long* const temp = new unsigned long long [(newsize * 3 + 7) / 8];
-      byte* const tmp = (byte*)temp;
-      byte* const bmp = (byte*)&data[54];
-
-      // encode
-      #pragma omp parallel for default(none) shared(width, w, h, bmp, tmp, newsize)
-      for (int y = 0; y < h; y++) {
-        int p0 = 0, p1 = 0, p2 = 0;
-        if (y > 0) {  // pixel y DIFF
-          p0 = bmp[(y - 1) * width + 0];
-          p1 = bmp[(y - 1) * width + 1];
-          p2 = bmp[(y - 1) * width + 2];
+      T a [bits];
+      for (int i = 0; i < bits; i++) a[i] = h_BMP_BIT_load<T>(&in[(pos / bits + (long long)i * (esize / bits)) * sizeof(T)]);
+      h_BMP_BIT_transpose<T>(a);
+      for (int i = 0; i < bits; i++) out[pos + i] = a[i];
+    }
+  }
+
+  // copy leftover values
+  for (int i = esize; i < num; i++) {
+    out[i] = h_BMP_BIT_load<T>(&in[(long long)i * sizeof(T)]);
+  }
+}
+
+
+// estimate the encoded size of a predictor by counting the non-zero BIT bytes of a sample of row groups
+template <typename T, int C>
+static inline int h_BMP_BIT_cost(const byte* const bmp, const int width, const int w, const int h, const byte pred)
+{
+  const int bits = sizeof(T) * 8;
+  int cost = 0;
+  #pragma omp parallel for default(none) shared(bmp, width, w, h, pred, bits) reduction(+:cost)
+  for (int g = 1; g <= h - bits; g += bits * 8) {
+    for (int x = 1; x < w; x++) {
+      unsigned int o [C] = {};
+      for (int y = g; y < g + bits; y++) {
+        const h_BMP_BIT_samples<T> n = {&bmp[(long long)y * width + x * C * sizeof(T)]};
+        const h_BMP_BIT_samples<T> u = {&bmp[(long long)(y - 1) * width + x * C * sizeof(T)]};
+        unsigned int v [C];
+        for (int c = 0; c < C; c++) {
+          v[c] = n[c] - n[c - C];
+          if (pred == h_PRED_XY) v[c] -= u[c] - u[c - C];
         }
-        for (int x = 0; x < w; x++) {
-          // read and split into color channels
-          const int n0 = bmp[y * width + x * 3 + 0];
-          const int n1 = bmp[y * width + x * 3 + 1];
-          const int n2 = bmp[y * width + x * 3 + 2];
-
-          // pixel x DIFF
-          int v0 = n0 - p0;
-          int v1 = n1 - p1;
-          int v2 = n2 - p2;
-          p0 = n0;
-          p1 = n1;
-          p2 = n2;
-
-          // color-channel DIFF
-          v0 -= v1;
-          v2 -= v1;
-
-          // TCMS
-          v0 = ((v0 << 1) ^ ((v0 << 24) >> 31)) & 0xff;
-          v1 = ((v1 << 1) ^ ((v1 << 24) >> 31)) & 0xff;
-          v2 = ((v2 << 1) ^ ((v2 << 24) >> 31)) & 0xff;
-
-          // transpose, separate channels TUPL3, write encoded values
-          tmp[0 * newsize + y + x * h] = v0;
-          tmp[1 * newsize + y + x * h] = v1;
-          tmp[2 * newsize + y + x * h] = v2;
+        if constexpr (C >= 3) {
+          v[0] -= v[1];
+          v[2] -= v[1];
         }
+        for (int c = 0; c < C; c++) o[c] |= h_BMP_BIT_TCMS<T>(v[c]);
       }
+      for (int c = 0; c < C; c++) cost += __builtin_popcount(o[c]);
+    }
+  }
+  return cost;
+}
+
 
-      // BIT_1
-      const int csize = newsize * 3;
-      const int extra = csize % (8 * 8 / 8);
-      const int esize = csize - extra;
-      #pragma omp parallel for default(none) shared(esize, bmp, temp)
-      for (int pos = 0; pos < esize; pos += 8) {
-        unsigned long long t, x;
-        x = temp[pos / 8];
-        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
-        x = x ^ t ^ (t << 7);
-        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
-        x = x ^ t ^ (t << 14);
-        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
-        x = x ^ t ^ (t << 28);
-        for (int i = 0; i < 8; i++) {
-          bmp[pos / 8 + i * (esize / 8)] = x >> (i * 8);
+// transform w x h pixels with C channels of type T and a row stride of width bytes into C transposed channel planes
+// (channels 0 and 2 are predicted from channel 1, a fourth channel (alpha) is predicted independently)
+template <typename T, int C>
+static inline void h_BMP_BIT_encode(const byte* const __restrict__ bmp, const int width, const int w, const int h, const byte pred, const int shift, T* const __restrict__ tmp)
+{
+  const int newsize = w * h;
+  #pragma omp parallel for default(none) shared(width, w, h, bmp, tmp, newsize, pred, shift)
+  for (int y = 0; y < h; y++) {
+    const h_BMP_BIT_samples<T> row = {&bmp[(long long)y * width]};
+    const h_BMP_BIT_samples<T> up = {(y > 0) ? &bmp[(long long)(y - 1) * width] : row.p};
+    unsigned int p [C] = {};
+    if (y > 0) {  // pixel y DIFF
+      for (int c = 0; c < C; c++) p[c] = up[c] >> shift;
+    }
+    for (int x = 0; x < w; x++) {
+      unsigned int v [C];
+      for (int c = 0; c < C; c++) {
+        // read and split into channels
+        const unsigned int n = row[x * C + c] >> shift;
+
+        // pixel x DIFF
+        v[c] = n - p[c];
+        p[c] = n;
+
+        // pixel y DIFF of x DIFFs (gradient)
+        if ((pred == h_PRED_XY) && (y > 0) && (x > 0)) {
+          v[c] -= (up[x * C + c] >> shift) - (up[x * C + c - C] >> shift);
         }
       }
 
-      // copy leftover bytes
-      for (int i = 0; i < extra; i++) {
-        bmp[csize - extra + i] = tmp[csize - extra + i];
+      // color-channel DIFF
+      if constexpr (C >= 3) {
+        v[0] -= v[1];
+        v[2] -= v[1];
       }
 
-      // handle padding (if any)
-      for (int i = newsize * 3; i < width * h; i++) {
-        bmp[i] = 0;
+      // TCMS, transpose, separate channels TUPLC, write encoded values
+      for (int c = 0; c < C; c++) {
+        tmp[c * newsize + y + x * h] = h_BMP_BIT_TCMS<T>(v[c]);
       }
-
-      delete [] temp;
     }
   }
 }
 
 
-static inline void h_iBMP_BIT(int& size, byte*& data)
+// target of the inverse transform that leaves the decoded rows where they are
+struct h_BMP_BIT_keep
 {
-  assert(sizeof(unsigned long long) == 8);
+  template <typename T, int C>
+  void put(const int, const h_BMP_BIT_samples<T>) const {}
+};
 
-  if (size < 54) {
-    printf("h_BMP_BIT: WARNING file size is too small for a BMP image\n");
-  } else {
-    const int w = h_BMP_BIT_get4(&data[18]);
-    const int h = h_BMP_BIT_get4(&data[22]);
-    const int pad = ((w * 3 + 3) & ~3) - (w * 3);
-    const int width = w * 3 + pad;
-    if ((data[0] != 0) || (data[1] != 0) || (h_BMP_BIT_get4(&data[2]) != 0) || (h_BMP_BIT_get4(&data[10]) != 0) || (h_BMP_BIT_get4(&data[14]) != 0) || (h_BMP_BIT_get2(&data[26]) != 0) || (h_BMP_BIT_get2(&data[28]) != 0) || (h_BMP_BIT_get4(&data[30]) != 0) || (h_BMP_BIT_get4(&data[34]) != 0) || (h_BMP_BIT_get4(&data[46]) != 0) || (h_BMP_BIT_get4(&data[50]) != 0) || (w < 1) || (h < 1)) {
-      printf("h_BMP_BIT: WARNING not a supported BMP format\n");
-    } else {
-      data[0] = data[0] + 'B';  // B
-      data[1] = data[1] + 'M';  // M
-      h_BMP_BIT_set4(&data[2], h_BMP_BIT_get4(&data[2]) + (h * width + 54));  // size in bytes
-      //h_BMP_BIT_set4(&data[6], h_BMP_BIT_get4(&data[6]));  // 2 reserved values (0, 0)
-      h_BMP_BIT_set4(&data[10], h_BMP_BIT_get4(&data[10]) + 54);  // offset to image data (54)
-      h_BMP_BIT_set4(&data[14], h_BMP_BIT_get4(&data[14]) + 40);  // header size (40)
-      //h_BMP_BIT_set4(&data[18], w);  // width
-      //h_BMP_BIT_set4(&data[22], h);  // height
-      h_BMP_BIT_set2(&data[26], h_BMP_BIT_get2(&data[26]) + 1);  // color planes (must be 1)
-      h_BMP_BIT_set2(&data[28], h_BMP_BIT_get2(&data[28]) + 24);  // bits per pixel (only 24 supported)
-      //h_BMP_BIT_set4(&data[30], h_BMP_BIT_get4(&data[30]) + 0);  // compression method (only 0 supported)
-      h_BMP_BIT_set4(&data[34], h_BMP_BIT_get4(&data[34]) + (h * width));  // image size
-      //h_BMP_BIT_set4(&data[38], h_BMP_BIT_get4(&data[38]));  // horizontal resolution
-      h_BMP_BIT_set4(&data[42], h_BMP_BIT_get4(&data[42]) + h_BMP_BIT_get4(&data[38]));  // vertical resolution [same as previous?]
-      //h_BMP_BIT_set4(&data[46], h_BMP_BIT_get4(&data[46]) + 0);  // number of colors or 0
-      //h_BMP_BIT_set4(&data[50], h_BMP_BIT_get4(&data[50]) + 0);  // important colors or 0
-
-      const int newsize = w * h * sizeof(byte);
-      unsigned long long* const temp = new unsigned long long [(newsize * 3 + 7) / 8];
-      byte* const tmp = (byte*)temp;
-      byte* const bmp = (byte*)&data[54];
-
-      // iBIT_1
-      const int csize = newsize * 3;
-      const int extra = csize % (8 * 8 / 8);
-      const int esize = csize - extra;
-      #pragma omp parallel for default(none) shared(esize, bmp, temp)
-      for (int pos = 0; pos < esize; pos += 8) {
-        unsigned long long t, x = 0;
-        for (int i = 0; i < 8; i++) x |= (unsigned long long)bmp[pos / 8 + i * (esize / 8)] << (i * 8);
-        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
-        x = x ^ t ^ (t << 7);
-        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
-        x = x ^ t ^ (t << 14);
-        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
-        x = x ^ t ^ (t << 28);
-        temp[pos / 8] = x;
+
+// inverse of h_BMP_BIT_encode (the rows are rebuilt in bmp, and each finished row y is also handed to out.put<T, C>(y, row) while it is in cache)
+template <typename T, int C, typename S = h_BMP_BIT_keep>
+static inline void h_BMP_BIT_decode(T* const __restrict__ tmp, const int w, const int h, const byte pred, const int shift, byte* const __restrict__ bmp, const int width, const S& out = S())
+{
+  const int newsize = w * h;
+
+  // decode first column
+  unsigned int prev [C] = {};
+  for (int y = 0; y < h; y++) {
+    byte* const row = &bmp[(long long)y * width];
+
+    // read values, combine channels iTUPLC, inverse transpose, inverse TCMS
+    unsigned int v [C];
+    for (int c = 0; c < C; c++) v[c] = h_BMP_BIT_iTCMS<T>(tmp[c * newsize + y]);
+
+    // inverse color-channel DIFF
+    if constexpr (C >= 3) {
+      v[0] += v[1];
+      v[2] += v[1];
+    }
+
+    // inverse pixel y DIFF, write decoded values
+    for (int c = 0; c < C; c++) {
+      prev[c] = (T)(v[c] + prev[c]);
+      h_BMP_BIT_store<T>(&row[c * sizeof(T)], (T)prev[c]);
+    }
+  }
+
+  // inverse pixel y DIFF of x DIFFs (gradient)
+  if (pred == h_PRED_XY) {
+    #pragma omp parallel for default(none) shared(w, h, tmp, newsize)
+    for (int x = 1; x < w; x++) {
+      for (int c = 0; c < C; c++) {
+        T* const col = &tmp[c * newsize + x * h];
+        unsigned int sum = 0;
+        for (int y = 0; y < h; y++) {
+          sum += h_BMP_BIT_iTCMS<T>(col[y]);
+          col[y] = h_BMP_BIT_TCMS<T>(sum);
+        }
       }
+    }
+  }
 
-      // copy leftover bytes
-      for (int i = 0; i < extra; i++) {
-        tmp[csize - extra + i] = bmp[csize - extra + i];
+  // decode remaining columns
+  #pragma omp parallel for default(none) shared(width, w, h, tmp, bmp, newsize, shift, out)
+  for (int y = 0; y < h; y++) {
+    byte* const row = &bmp[(long long)y * width];
+    unsigned int prev [C];
+    for (int c = 0; c < C; c++) {
+      prev[c] = h_BMP_BIT_load<T>(&row[c * sizeof(T)]);
+      h_BMP_BIT_store<T>(&row[c * sizeof(T)], (T)(prev[c] << shift));
+    }
+    for (int x = 1; x < w; x++) {
+      // read values, combine channels iTUPLC, inverse transpose, inverse TCMS
+      unsigned int v [C];
+      for (int c = 0; c < C; c++) v[c] = h_BMP_BIT_iTCMS<T>(tmp[c * newsize + y + x * h]);
+
+      // inverse color-channel DIFF
+      if constexpr (C >= 3) {
+        v[0] += v[1];
+        v[2] += v[1];
       }
 
-      // decode
-      int prev0 = 0, prev1 = 0, prev2 = 0;
-      for (int y = 0; y < h; y++) {
-        // read values, combine channels iTUPL3, inverse transpose
-        int v0 = tmp[0 * newsize + y];
-        int v1 = tmp[1 * newsize + y];
-        int v2 = tmp[2 * newsize + y];
-
-        // inverse TCMS
-        v0 = (v0 >> 1) ^ ((v0 << 31) >> 31);
-        v1 = (v1 >> 1) ^ ((v1 << 31) >> 31);
-        v2 = (v2 >> 1) ^ ((v2 << 31) >> 31);
-
-        // inverse color-channel DIFF
-        v0 += v1;
-        v2 += v1;
-
-        // inverse pixel y DIFF
-        v0 += prev0;
-        v1 += prev1;
-        v2 += prev2;
-
-        // write decoded values
-        bmp[y * width + 0] = prev0 = v0;
-        bmp[y * width + 1] = prev1 = v1;
-        bmp[y * width + 2] = prev2 = v2;
+      // inverse pixel x DIFF, write decoded values
+      for (int c = 0; c < C; c++) {
+        prev[c] = (T)(v[c] + prev[c]);
+        h_BMP_BIT_store<T>(&row[(x * C + c) * sizeof(T)], (T)(prev[c] << shift));
       }
+    }
+    out.template put<T, C>(y, h_BMP_BIT_samples<T>{row});
+  }
+}
 
-      #pragma omp parallel for default(none) shared(width, w, h, tmp, bmp, newsize)
-      for (int y = 0; y < h; y++) {
-        int prev0 = bmp[y * width + 0];
-        int prev1 = bmp[y * width + 1];
-        int prev2 = bmp[y * width + 2];
-        for (int x = 1; x < w; x++) {
-          // read values, combine channels iTUPL3, inverse transpose
-          int v0 = tmp[0 * newsize + y + x * h];
-          int v1 = tmp[1 * newsize + y + x * h];
-          int v2 = tmp[2 * newsize + y + x * h];
-
-          // inverse TCMS
-          v0 = (v0 >> 1) ^ ((v0 << 31) >> 31);
-          v1 = (v1 >> 1) ^ ((v1 << 31) >> 31);
-          v2 = (v2 >> 1) ^ ((v2 << 31) >> 31);
-
-          // inverse color-channel DIFF
-          v0 += v1;
-          v2 += v1;
-
-          // inverse pixel x DIFF
-          v0 += prev0;
-          v1 += prev1;
-          v2 += prev2;
-
-          // write decoded values
-          bmp[y * width + x * 3 + 0] = prev0 = v0;
-          bmp[y * width + x * 3 + 1] = prev1 = v1;
-          bmp[y * width + x * 3 + 2] = prev2 = v2;
-        }
+
+// number of trailing bits that are zero in all channel values (e.g., 12-bit samples stored in the upper bits of 16-bit words)
+template <typename T, int C>
+static inline int h_BMP_BIT_shift(const byte* const bmp, const int width, const int w, const int h)
+{
+  unsigned int bits = 0;
+  #pragma omp parallel for default(none) shared(bmp, width, w, h) reduction(|:bits)
+  for (int y = 0; y < h; y++) {
+    const h_BMP_BIT_samples<T> row = {&bmp[(long long)y * width]};
+    for (int x = 0; x < w * C; x++) {
+      bits |= row[x];
+    }
+  }
+  return (bits == 0) ? 0 : __builtin_ctz(bits);
+}
+
+
+// transform a w x h image with C channels of type T in place (the leading w * h * C * sizeof(T) bytes receive the bit planes)
+template <typename T, int C>
+static inline void h_BMP_BIT_pixels(byte* const bmp, const int width, const int w, const int h, byte& pred, int& shift, h_arena& scratch)
+{
+  const int num = w * h * C;
+  T* const tmp = scratch.get<T>((long long)num * sizeof(T));
+
+  // drop trailing zero bits of wide channels
+  shift = (sizeof(T) > 1) ? h_BMP_BIT_shift<T, C>(bmp, width, w, h) : 0;
+
+  // pick predictor
+  if (pred == h_PRED_AUTO) {
+    pred = (h_BMP_BIT_cost<T, C>(bmp, width, w, h, h_PRED_XY) < h_BMP_BIT_cost<T, C>(bmp, width, w, h, h_PRED_X)) ? h_PRED_XY : h_PRED_X;
+  }
+
+  h_BMP_BIT_encode<T, C>(bmp, width, w, h, pred, shift, tmp);
+  h_BMP_BIT_BIT<T>(tmp, num, bmp);
+}
+
+
+template <typename T, int C, typename S = h_BMP_BIT_keep>
+static inline void h_iBMP_BIT_pixels(byte* const bmp, const int width, const int w, const int h, const byte pred, const int shift, h_arena& scratch, const S& out = S())
+{
+  const int num = w * h * C;
+  T* const tmp = scratch.get<T>((long long)num * sizeof(T));
+
+  h_BMP_BIT_iBIT<T>(bmp, num, tmp);
+  h_BMP_BIT_decode<T, C>(tmp, w, h, pred, shift, bmp, width, out);
+}
+
+
+// transform a w x h image with a runtime number (1 to 4) of channels of type T and no row padding in place
+template <typename T>
+static inline void h_BMP_BIT_channels(byte* const pix, const int w, const int h, const int C, byte& pred, int& shift, h_arena& scratch)
+{
+  const int width = w * C * sizeof(T);
+  switch (C) {
+    case 1: h_BMP_BIT_pixels<T, 1>(pix, width, w, h, pred, shift, scratch); break;
+    case 2: h_BMP_BIT_pixels<T, 2>(pix, width, w, h, pred, shift, scratch); break;
+    case 3: h_BMP_BIT_pixels<T, 3>(pix, width, w, h, pred, shift, scratch); break;
+    default: h_BMP_BIT_pixels<T, 4>(pix, width, w, h, pred, shift, scratch); break;
+  }
+}
+
+
+template <typename T>
+static inline void h_iBMP_BIT_channels(byte* const pix, const int w, const int h, const int C, const byte pred, const int shift, h_arena& scratch)
+{
+  const int width = w * C * sizeof(T);
+  switch (C) {
+    case 1: h_iBMP_BIT_pixels<T, 1>(pix, width, w, h, pred, shift, scratch); break;
+    case 2: h_iBMP_BIT_pixels<T, 2>(pix, width, w, h, pred, shift, scratch); break;
+    case 3: h_iBMP_BIT_pixels<T, 3>(pix, width, w, h, pred, shift, scratch); break;
+    default: h_iBMP_BIT_pixels<T, 4>(pix, width, w, h, pred, shift, scratch); break;
+  }
+}
+
+
+// pixels of decoded data that can be handed to a target row by row instead of being restored in their file layout
+struct h_image
+{
+  byte* pix;  // bit planes (transformed) or pixel rows (stored as is)
+  bool planes;  // whether pix holds bit planes that still need the inverse transform
+  int w, h, C;  // width, height, and channels (1 to 4)
+  int bytes;  // bytes per sample (1 or 2)
+  int width;  // bytes from one pixel row to the next (rows stored as is)
+  int shift;  // dropped trailing zero bits
+  int maxval;  // largest sample value
+  bool bgr;  // color channels are in B, G, R order (otherwise R, G, B)
+  bool bottomup;  // rows are stored from the bottom of the image to the top
+};
+
+
+// hand the rows of an image to out.put<T, C>(y, row) in storage order, running the inverse transform first if the image holds bit planes
+// (bit planes are decoded into packed rows in place, so the data of the image is clobbered)
+template <typename T, int C, typename S>
+static inline void h_iBMP_BIT_image(const h_image& img, const byte pred, h_arena& scratch, const S& out)
+{
+  if (img.planes) {
+    h_iBMP_BIT_pixels<T, C>(img.pix, img.w * C * sizeof(T), img.w, img.h, pred, img.shift, scratch, out);
+  } else {
+    #pragma omp parallel for default(none) shared(img, out)
+    for (int y = 0; y < img.h; y++) {
+      out.template put<T, C>(y, h_BMP_BIT_samples<T>{&img.pix[(long long)y * img.width]});
+    }
+  }
+}
+
+
+template <typename S>
+static inline void h_iBMP_BIT_image(const h_image& img, const byte pred, h_arena& scratch, const S& out)
+{
+  if (img.bytes == 1) {
+    switch (img.C) {
+      case 1: h_iBMP_BIT_image<byte, 1>(img, pred, scratch, out); break;
+      case 2: h_iBMP_BIT_image<byte, 2>(img, pred, scratch, out); break;
+      case 3: h_iBMP_BIT_image<byte, 3>(img, pred, scratch, out); break;
+      default: h_iBMP_BIT_image<byte, 4>(img, pred, scratch, out); break;
+    }
+  } else {
+    switch (img.C) {
+      case 1: h_iBMP_BIT_image<unsigned short, 1>(img, pred, scratch, out); break;
+      case 2: h_iBMP_BIT_image<unsigned short, 2>(img, pred, scratch, out); break;
+      case 3: h_iBMP_BIT_image<unsigned short, 3>(img, pred, scratch, out); break;
+      default: h_iBMP_BIT_image<unsigned short, 4>(img, pred, scratch, out); break;
+    }
+  }
+}
+
+
+// bilevel images: XOR each row with the previous row so that runs of unchanged pixels become zero words for ZERE
+static inline void h_BMP_BIT_bilevel(byte* const bmp, const int width, const int h)
+{
+  const int num = width / sizeof(unsigned int);
+  #pragma omp parallel for default(none) shared(bmp, width, num, h)
+  for (int b = 0; b < num; b += 256) {
+    const int e = std::min(num, b + 256);
+    for (int y = h - 1; y > 0; y--) {
+      byte* const row = &bmp[(long long)y * width];
+      for (int x = b; x < e; x++) {
+        const int o = x * sizeof(unsigned int);
+        h_BMP_BIT_store<unsigned int>(&row[o], h_BMP_BIT_load<unsigned int>(&row[o]) ^ h_BMP_BIT_load<unsigned int>(&row[o - width]));
       }
+    }
+  }
+}
 
-      // set padding bytes (if any) to zero
-      if (pad > 0) {
-        for (int y = 0; y < h; y++) {
-          for (int x = w * 3; x < width; x++) {
-            bmp[y * width + x] = 0;
-          }
-        }
+
+static inline void h_iBMP_BIT_bilevel(byte* const bmp, const int width, const int h)
+{
+  const int num = width / sizeof(unsigned int);
+  #pragma omp parallel for default(none) shared(bmp, width, num, h)
+  for (int b = 0; b < num; b += 256) {
+    const int e = std::min(num, b + 256);
+    for (int y = 1; y < h; y++) {
+      byte* const row = &bmp[(long long)y * width];
+      for (int x = b; x < e; x++) {
+        const int o = x * sizeof(unsigned int);
+        h_BMP_BIT_store<unsigned int>(&row[o], h_BMP_BIT_load<unsigned int>(&row[o]) ^ h_BMP_BIT_load<unsigned int>(&row[o - width]));
+      }
+    }
+  }
+}
+
+
+// number of bytes in a row of w pixels (without padding) of the supported pixel formats or 0
+static inline int h_BMP_BIT_bytes(const int w, const int bpp)
+{
+  if ((w < 1) || (w > 0x7ffffff0 / 48)) return 0;
+  return ((bpp == 1) || (bpp == 8) || (bpp == 24) || (bpp == 32) || (bpp == 48)) ? ((w * bpp + 7) / 8) : 0;
+}
+
+
+// number of palette bytes (colors is the number of used colors or 0 for all)
+static inline int h_BMP_BIT_palette(const int bpp, const int colors)
+{
+  if ((bpp > 8) || (colors < 0) || (colors > (1 << bpp))) return 0;
+  return ((colors == 0) ? (1 << bpp) : colors) * 4;
+}
+
+
+// supported DIB header sizes (BITMAPINFOHEADER, V2, V3, V4, and V5)
+static inline bool h_BMP_BIT_header(const int hs)
+{
+  return (hs == 40) || (hs == 52) || (hs == 56) || (hs == 108) || (hs == 124);
+}
+
+
+// usual offset of the pixel array (file header, DIB header, bit masks that follow a 40-byte header, and palette); any gap bytes before the actual offset are kept as is
+static inline int h_BMP_BIT_offset(const int hs, const int bpp, const int colors, const int comp)
+{
+  return 14 + hs + (((hs == 40) && (comp == 3)) ? 12 : 0) + h_BMP_BIT_palette(bpp, colors);
+}
+
+
+// check that the padding bytes at the end of each row are zero (the inverse transform recreates them as zeros)
+static inline bool h_BMP_BIT_padding(const byte* const bmp, const int bytes, const int width, const int h)
+{
+  bool zero = true;
+  for (int y = 0; (y < h) && zero; y++) {
+    for (int x = bytes; x < width; x++) {
+      zero = zero && (bmp[(long long)y * width + x] == 0);
+    }
+  }
+  return zero;
+}
+
+
+// the header and any gap or trailing bytes (e.g., bit masks, color space, or ICC profile data) are kept as is except for a few predictable fields; only the pixel array is transformed
+// (bottom-up and top-down images are handled alike because rows are transformed in storage order)
+static inline bool h_BMP_BIT(int& size, byte*& data, byte& pred, h_arena& scratch)
+{
+  assert(sizeof(unsigned long long) == 8);
+
+  if (pred == h_PRED_NONE) return false;
+  if (size < 54) return false;  // too small for a BMP image
+  const int hs = h_BMP_BIT_get4(&data[14]);
+  const int w = h_BMP_BIT_get4(&data[18]);
+  const int sh = h_BMP_BIT_get4(&data[22]);  // negative for top-down images
+  const int h = (sh < 0) ? -std::max(sh, -0x7fffffff) : sh;
+  const int bpp = h_BMP_BIT_get2(&data[28]);
+  const int comp = h_BMP_BIT_get4(&data[30]);
+  const int colors = h_BMP_BIT_get4(&data[46]);
+  const int bytes = h_BMP_BIT_bytes(w, bpp);
+  const int pad = ((bytes + 3) & ~3) - bytes;
+  const int width = bytes + pad;
+  const int off = h_BMP_BIT_get4(&data[10]);
+  if ((data[0] != 'B') || (data[1] != 'M') || !h_BMP_BIT_header(hs) || (size < 14 + hs) || (h_BMP_BIT_get2(&data[26]) != 1) || (bytes == 0) || ((comp != 0) && ((comp != 3) || (bpp != 32))) || (w < 1) || (h < 1) || (off < 14 + hs) || (off > size) || ((long long)h * width > size - off) || !h_BMP_BIT_padding(&data[off], (bpp == 1) ? width : bytes, width, h)) return false;  // not a supported BMP format
+  data[0] = data[0] - 'B';  // B
+  data[1] = data[1] - 'M';  // M
+  h_BMP_BIT_set4(&data[2], (unsigned int)h_BMP_BIT_get4(&data[2]) - size);  // size in bytes
+  //h_BMP_BIT_set4(&data[6], h_BMP_BIT_get4(&data[6]));  // 2 reserved values (0, 0)
+  h_BMP_BIT_set4(&data[10], off - h_BMP_BIT_offset(hs, bpp, colors, comp));  // offset to image data (usually header plus palette)
+  h_BMP_BIT_set4(&data[14], hs - 40);  // header size (40, 52, 56, 108, or 124)
+  //h_BMP_BIT_set4(&data[18], w);  // width
+  //h_BMP_BIT_set4(&data[22], sh);  // height
+  h_BMP_BIT_set2(&data[26], h_BMP_BIT_get2(&data[26]) - 1);  // color planes (must be 1)
+  h_BMP_BIT_set2(&data[28], h_BMP_BIT_get2(&data[28]) - 24);  // bits per pixel (1, 8, 24, 32, or 48)
+  h_BMP_BIT_set4(&data[34], (unsigned int)h_BMP_BIT_get4(&data[34]) - (h * width));  // image size (may be 0)
+  //h_BMP_BIT_set4(&data[38], h_BMP_BIT_get4(&data[38]));  // horizontal resolution
+  h_BMP_BIT_set4(&data[42], (unsigned int)h_BMP_BIT_get4(&data[42]) - h_BMP_BIT_get4(&data[38]));  // vertical resolution [same as previous?]
+  //h_BMP_BIT_set4(&data[46], h_BMP_BIT_get4(&data[46]));  // number of colors or 0
+  //h_BMP_BIT_set4(&data[50], h_BMP_BIT_get4(&data[50]));  // important colors or 0
+
+  byte* const bmp = (byte*)&data[off];
+  int shift = 0;
+  if (bpp == 1) {
+    h_BMP_BIT_bilevel(bmp, width, h);
+    pred = h_PRED_X;
+  } else if (bpp == 8) {
+    h_BMP_BIT_pixels<byte, 1>(bmp, width, w, h, pred, shift, scratch);
+  } else if (bpp == 24) {
+    h_BMP_BIT_pixels<byte, 3>(bmp, width, w, h, pred, shift, scratch);
+  } else if (bpp == 32) {
+    h_BMP_BIT_pixels<byte, 4>(bmp, width, w, h, pred, shift, scratch);
+  } else {
+    h_BMP_BIT_pixels<unsigned short, 3>(bmp, width, w, h, pred, shift, scratch);
+  }
+  data[31] = shift;  // compression method (0 or 3) leaves the second byte free for the number of dropped trailing zero bits
+
+  // handle padding (if any)
+  if (bpp != 1) {
+    for (int i = bytes * h; i < width * h; i++) {
+      bmp[i] = 0;
+    }
+  }
+  return true;
+}
+
+
+static inline bool h_iBMP_BIT(int& size, byte*& data, const byte pred, h_arena& scratch)
+{
+  assert(sizeof(unsigned long long) == 8);
+
+  if (pred == h_PRED_NONE) return false;
+  if (size < 54) return false;  // too small for a BMP image
+  const int hs = std::min(h_BMP_BIT_get4(&data[14]), 124) + 40;  // clamped so that the sum cannot overflow
+  const int w = h_BMP_BIT_get4(&data[18]);
+  const int sh = h_BMP_BIT_get4(&data[22]);
+  const int h = (sh < 0) ? -std::max(sh, -0x7fffffff) : sh;
+  const int bpp = (h_BMP_BIT_get2(&data[28]) + 24) & 0xffff;
+  const int comp = data[30];
+  const int shift = data[31];
+  const int colors = h_BMP_BIT_get4(&data[46]);
+  const int bytes = h_BMP_BIT_bytes(w, bpp);
+  const int pad = ((bytes + 3) & ~3) - bytes;
+  const int width = bytes + pad;
+  const long long off = (long long)h_BMP_BIT_get4(&data[10]) + h_BMP_BIT_offset(hs, bpp, colors, comp);
+  if ((data[0] != 0) || (data[1] != 0) || !h_BMP_BIT_header(hs) || (size < 14 + hs) || (h_BMP_BIT_get2(&data[26]) != 0) || (bytes == 0) || (h_BMP_BIT_get2(&data[32]) != 0) || ((comp != 0) && ((comp != 3) || (bpp != 32))) || (shift >= 16) || (w < 1) || (h < 1) || (off < 14 + hs) || (off > size) || ((long long)h * width > size - off)) return false;  // not a supported BMP format
+  data[0] = data[0] + 'B';  // B
+  data[1] = data[1] + 'M';  // M
+  h_BMP_BIT_set4(&data[2], (unsigned int)h_BMP_BIT_get4(&data[2]) + size);  // size in bytes
+  //h_BMP_BIT_set4(&data[6], h_BMP_BIT_get4(&data[6]));  // 2 reserved values (0, 0)
+  h_BMP_BIT_set4(&data[10], off);  // offset to image data (usually header plus palette)
+  h_BMP_BIT_set4(&data[14], hs);  // header size (40, 52, 56, 108, or 124)
+  //h_BMP_BIT_set4(&data[18], w);  // width
+  //h_BMP_BIT_set4(&data[22], sh);  // height
+  h_BMP_BIT_set2(&data[26], h_BMP_BIT_get2(&data[26]) + 1);  // color planes (must be 1)
+  h_BMP_BIT_set2(&data[28], h_BMP_BIT_get2(&data[28]) + 24);  // bits per pixel (1, 8, 24, 32, or 48)
+  h_BMP_BIT_set4(&data[34], (unsigned int)h_BMP_BIT_get4(&data[34]) + (h * width));  // image size (may be 0)
+  //h_BMP_BIT_set4(&data[38], h_BMP_BIT_get4(&data[38]));  // horizontal resolution
+  h_BMP_BIT_set4(&data[42], (unsigned int)h_BMP_BIT_get4(&data[42]) + h_BMP_BIT_get4(&data[38]));  // vertical resolution [same as previous?]
+  //h_BMP_BIT_set4(&data[46], h_BMP_BIT_get4(&data[46]));  // number of colors or 0
+  //h_BMP_BIT_set4(&data[50], h_BMP_BIT_get4(&data[50]));  // important colors or 0
+  data[31] = 0;  // compression method (0 or 3)
+
+  byte* const bmp = (byte*)&data[off];
+  if (bpp == 1) {
+    h_iBMP_BIT_bilevel(bmp, width, h);
+  } else if (bpp == 8) {
+    h_iBMP_BIT_pixels<byte, 1>(bmp, width, w, h, pred, shift, scratch);
+  } else if (bpp == 24) {
+    h_iBMP_BIT_pixels<byte, 3>(bmp, width, w, h, pred, shift, scratch);
+  } else if (bpp == 32) {
+    h_iBMP_BIT_pixels<byte, 4>(bmp, width, w, h, pred, shift, scratch);
+  } else {
+    h_iBMP_BIT_pixels<unsigned short, 3>(bmp, width, w, h, pred, shift, scratch);
+  }
+
+  // set padding bytes (if any) to zero
+  if ((pad > 0) && (bpp != 1)) {
+    for (int y = 0; y < h; y++) {
+      for (int x = bytes; x < width; x++) {
+        bmp[(long long)y * width + x] = 0;
       }
+    }
+  }
+  return true;
+}
 
-      delete [] temp;
+
+// describe the pixels of a BMP image that has been transformed (or stored as is if transformed is false) without restoring it;
+// images with fewer than 8 bits per pixel and palette images whose palette is not the gray ramp are not supported
+static inline bool h_BMP_BIT_image(byte* const data, const int size, const bool transformed, h_image& img)
+{
+  if (size < 54) return false;
+  const int t = transformed ? 1 : 0;
+  const int hs = std::min(h_BMP_BIT_get4(&data[14]), 124) + t * 40;  // clamped so that the sum cannot overflow
+  const int w = h_BMP_BIT_get4(&data[18]);
+  const int sh = h_BMP_BIT_get4(&data[22]);
+  const int h = (sh < 0) ? -std::max(sh, -0x7fffffff) : sh;
+  const int bpp = (h_BMP_BIT_get2(&data[28]) + t * 24) & 0xffff;
+  const int comp = data[30];
+  const int colors = h_BMP_BIT_get4(&data[46]);
+  const int bytes = h_BMP_BIT_bytes(w, bpp);
+  const int width = (bytes + 3) & ~3;
+  const long long off = transformed ? ((long long)h_BMP_BIT_get4(&data[10]) + h_BMP_BIT_offset(hs, bpp, colors, comp)) : h_BMP_BIT_get4(&data[10]);
+  if ((data[0] != (transformed ? 0 : 'B')) || (data[1] != (transformed ? 0 : 'M')) || !h_BMP_BIT_header(hs) || (size < 14 + hs) || ((bpp != 8) && (bpp != 24) && (bpp != 32) && (bpp != 48)) || (bytes == 0) || (h_BMP_BIT_get2(&data[32]) != 0) || (!transformed && (data[31] != 0)) || ((comp != 0) && ((comp != 3) || (bpp != 32))) || (w < 1) || (h < 1) || (off < 14 + hs) || (off > size) || ((long long)h * width > size - off)) return false;
+  if (bpp == 8) {
+    // only gray ramps make the indices usable as samples
+    const int num = (colors == 0) ? 256 : colors;
+    if ((num < 1) || (num > 256) || (14 + hs + 4 * num > off)) return false;
+    for (int i = 0; i < num; i++) {
+      const byte* const entry = &data[14 + hs + 4 * i];
+      if ((entry[0] != i) || (entry[1] != i) || (entry[2] != i)) return false;
     }
   }
+  img.pix = &data[off];
+  img.planes = transformed;
+  img.w = w;
+  img.h = h;
+  img.C = (bpp == 8) ? 1 : ((bpp == 32) ? 4 : 3);
+  img.bytes = (bpp == 48) ? 2 : 1;
+  img.width = width;
+  img.shift = transformed ? data[31] : 0;
+  img.maxval = (bpp == 48) ? 0xffff : 0xff;
+  img.bgr = true;
+  img.bottomup = (sh > 0);
+  return (img.shift < 16);
 }
 
 
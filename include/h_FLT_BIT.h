@@ -0,0 +1,123 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+#ifndef flt_bit
+#define flt_bit
+
+
+#include "h_BMP_BIT.h"
+
+
+static const int h_FLT_BIT_side = 12;  // width, height, and number of dropped trailing zero bits
+
+
+// map the bits of a float to an unsigned int that preserves the order of the values and the trailing zero bits
+// (the sign and magnitude become a biased two's complement number, -0.0 maps to the otherwise unused 0)
+static inline unsigned int h_FLT_BIT_map(const unsigned int u)
+{
+  const unsigned int mag = u & 0x7fffffff;
+  if ((u >> 31) == 0) return mag + 0x80000000;
+  return (mag == 0) ? 0 : (0x80000000 - mag);
+}
+
+
+static inline unsigned int h_FLT_BIT_imap(const unsigned int v)
+{
+  if (v >= 0x80000000) return v - 0x80000000;
+  return (v == 0) ? 0x80000000 : (0x80000000 | (0x80000000 - v));
+}
+
+
+// transform a w x h field of 32-bit floats (size must be w * h * 4 bytes) from data into out, which has room for h_FLT_BIT_side + size bytes; the data grows by h_FLT_BIT_side bytes
+static inline bool h_FLT_BIT(int& size, const byte* const data, byte* const out, const int w, const int h, byte& pred, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  if ((w < 1) || (h < 1) || (h_BMP_BIT_extent(w, h, 4) != size)) return false;  // size does not match a w x h field of floats
+
+  const int num = w * h;
+  const unsigned int* const in = (const unsigned int*)data;
+  unsigned int* const val = (unsigned int*)&out[h_FLT_BIT_side];
+
+  // map floats to ordered integers
+  #pragma omp parallel for default(none) shared(in, val, num)
+  for (int i = 0; i < num; i++) {
+    val[i] = h_FLT_BIT_map(in[i]);
+  }
+
+  // 2D DIFF, TCMS, and 32 bit planes
+  int shift;
+  h_BMP_BIT_pixels<unsigned int, 1>((byte*)val, w * sizeof(float), w, h, pred, shift, scratch);
+
+  h_BMP_BIT_set4(&out[0], w);
+  h_BMP_BIT_set4(&out[4], h);
+  h_BMP_BIT_set4(&out[8], shift);
+
+  size += h_FLT_BIT_side;
+  return true;
+}
+
+
+// the floats are restored in place after the side information, which data then skips
+static inline bool h_iFLT_BIT(int& size, byte*& data, const byte pred, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  const int w = (size < h_FLT_BIT_side) ? 0 : h_BMP_BIT_get4(&data[0]);
+  const int h = (size < h_FLT_BIT_side) ? 0 : h_BMP_BIT_get4(&data[4]);
+  const int shift = (size < h_FLT_BIT_side) ? 0 : h_BMP_BIT_get4(&data[8]);
+  if ((w < 1) || (h < 1) || (shift < 0) || (shift >= 32) || (h_BMP_BIT_extent(w, h, 4) + h_FLT_BIT_side != size)) return false;  // not a supported float field
+
+  const int num = w * h;
+  unsigned int* const val = (unsigned int*)&data[h_FLT_BIT_side];
+
+  // inverse 32 bit planes, TCMS, and 2D DIFF
+  h_iBMP_BIT_pixels<unsigned int, 1>((byte*)val, w * sizeof(float), w, h, pred, shift, scratch);
+
+  // map ordered integers back to floats
+  #pragma omp parallel for default(none) shared(val, num)
+  for (int i = 0; i < num; i++) {
+    val[i] = h_FLT_BIT_imap(val[i]);
+  }
+
+  data += h_FLT_BIT_side;
+  size -= h_FLT_BIT_side;
+  return true;
+}
+
+
+#endif
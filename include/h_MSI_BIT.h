@@ -0,0 +1,262 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+
+#ifndef msi_bit
+#define msi_bit
+
+
+#include "h_BMP_BIT.h"
+
+
+static const int h_MSI_BIT_side = 28;  // width, height, bands, bytes per sample, layout, reference band, and number of dropped trailing zero bits
+
+// sample layouts
+static const int h_MSI_BIT_BIP = 0;  // band interleaved by pixel (the bands of a pixel are adjacent)
+static const int h_MSI_BIT_BSQ = 1;  // band sequential (planar, one w x h image per band)
+
+// inter-band predictors
+static const int h_MSI_BIT_PREV = -1;  // predict each band from the previous band (any other value selects a fixed reference band)
+
+
+// inter-band DIFF of the spatial residuals (in TCMS form) of n bands with newsize values each, processed in blocks of positions to limit the number of concurrent streams
+template <typename T>
+static inline void h_MSI_BIT_diff(T* const tmp, const int newsize, const int n, const int ref)
+{
+  #pragma omp parallel for default(none) shared(tmp, newsize, n, ref)
+  for (int beg = 0; beg < newsize; beg += 4096) {
+    const int end = std::min(newsize, beg + 4096);
+    if (ref == h_MSI_BIT_PREV) {
+      for (int b = n - 1; b > 0; b--) {
+        T* const cur = &tmp[b * newsize];
+        const T* const prv = &tmp[(b - 1) * newsize];
+        for (int i = beg; i < end; i++) {
+          cur[i] = h_BMP_BIT_TCMS<T>(h_BMP_BIT_iTCMS<T>(cur[i]) - h_BMP_BIT_iTCMS<T>(prv[i]));
+        }
+      }
+    } else {
+      const T* const rb = &tmp[ref * newsize];
+      for (int b = 0; b < n; b++) {
+        if (b != ref) {
+          T* const cur = &tmp[b * newsize];
+          for (int i = beg; i < end; i++) {
+            cur[i] = h_BMP_BIT_TCMS<T>(h_BMP_BIT_iTCMS<T>(cur[i]) - h_BMP_BIT_iTCMS<T>(rb[i]));
+          }
+        }
+      }
+    }
+  }
+}
+
+
+template <typename T>
+static inline void h_MSI_BIT_idiff(T* const tmp, const int newsize, const int n, const int ref)
+{
+  #pragma omp parallel for default(none) shared(tmp, newsize, n, ref)
+  for (int beg = 0; beg < newsize; beg += 4096) {
+    const int end = std::min(newsize, beg + 4096);
+    if (ref == h_MSI_BIT_PREV) {
+      for (int b = 1; b < n; b++) {
+        T* const cur = &tmp[b * newsize];
+        const T* const prv = &tmp[(b - 1) * newsize];
+        for (int i = beg; i < end; i++) {
+          cur[i] = h_BMP_BIT_TCMS<T>(h_BMP_BIT_iTCMS<T>(cur[i]) + h_BMP_BIT_iTCMS<T>(prv[i]));
+        }
+      }
+    } else {
+      const T* const rb = &tmp[ref * newsize];
+      for (int b = 0; b < n; b++) {
+        if (b != ref) {
+          T* const cur = &tmp[b * newsize];
+          for (int i = beg; i < end; i++) {
+            cur[i] = h_BMP_BIT_TCMS<T>(h_BMP_BIT_iTCMS<T>(cur[i]) + h_BMP_BIT_iTCMS<T>(rb[i]));
+          }
+        }
+      }
+    }
+  }
+}
+
+
+// convert between band-interleaved and planar order
+template <typename T>
+static inline void h_MSI_BIT_planar(const T* const __restrict__ in, const int newsize, const int n, T* const __restrict__ out)
+{
+  #pragma omp parallel for default(none) shared(in, newsize, n, out)
+  for (int i = 0; i < newsize; i++) {
+    for (int b = 0; b < n; b++) {
+      out[b * newsize + i] = in[i * n + b];
+    }
+  }
+}
+
+
+template <typename T>
+static inline void h_MSI_BIT_interleaved(const T* const __restrict__ in, const int newsize, const int n, T* const __restrict__ out)
+{
+  #pragma omp parallel for default(none) shared(in, newsize, n, out)
+  for (int i = 0; i < newsize; i++) {
+    for (int b = 0; b < n; b++) {
+      out[i * n + b] = in[b * newsize + i];
+    }
+  }
+}
+
+
+// transform n planar w x h bands of type T into out: per-band 2D DIFF, inter-band DIFF, TCMS, and per-band bit planes (tmp has room for the n bands)
+template <typename T>
+static inline void h_MSI_BIT_bands(const T* const src, const int w, const int h, const int n, const int ref, byte& pred, const int shift, T* const out, T* const tmp)
+{
+  const int newsize = w * h;
+
+  // pick predictor (the bands are stacked into one tall image)
+  if (pred == h_PRED_AUTO) {
+    pred = (h_BMP_BIT_cost<T, 1>((const byte*)src, w * sizeof(T), w, h * n, h_PRED_XY) < h_BMP_BIT_cost<T, 1>((const byte*)src, w * sizeof(T), w, h * n, h_PRED_X)) ? h_PRED_XY : h_PRED_X;
+  }
+
+  for (int b = 0; b < n; b++) {
+    h_BMP_BIT_encode<T, 1>((const byte*)&src[b * newsize], w * sizeof(T), w, h, pred, shift, &tmp[b * newsize]);
+  }
+  if (n > 1) h_MSI_BIT_diff<T>(tmp, newsize, n, ref);
+  for (int b = 0; b < n; b++) {
+    h_BMP_BIT_BIT<T>(&tmp[b * newsize], newsize, (byte*)&out[b * newsize]);
+  }
+}
+
+
+template <typename T>
+static inline void h_iMSI_BIT_bands(const T* const in, const int w, const int h, const int n, const int ref, const byte pred, const int shift, T* const dst, T* const tmp)
+{
+  const int newsize = w * h;
+
+  for (int b = 0; b < n; b++) {
+    h_BMP_BIT_iBIT<T>((const byte*)&in[b * newsize], newsize, &tmp[b * newsize]);
+  }
+  if (n > 1) h_MSI_BIT_idiff<T>(tmp, newsize, n, ref);
+  for (int b = 0; b < n; b++) {
+    h_BMP_BIT_decode<T, 1>(&tmp[b * newsize], w, h, pred, shift, (byte*)&dst[b * newsize], w * sizeof(T));
+  }
+}
+
+
+// transform a w x h image with n bands of 1- or 2-byte samples (size must be w * h * n * bytes) from data into out, which has room for h_MSI_BIT_side + size bytes
+// (interleaved bands are brought into planar order in the planes arena); the data grows by h_MSI_BIT_side bytes
+static inline bool h_MSI_BIT(int& size, const byte* const data, byte* const out, const int w, const int h, const int n, const int bytes, const int layout, const int ref, byte& pred, h_arena& planes, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  if ((w < 1) || (h < 1) || (n < 1) || ((bytes != 1) && (bytes != 2)) || ((layout != h_MSI_BIT_BIP) && (layout != h_MSI_BIT_BSQ)) || (ref < h_MSI_BIT_PREV) || (ref >= n) || (h_BMP_BIT_extent(w, h, n, bytes) != size)) return false;  // size does not match the geometry
+
+  const int newsize = w * h;
+
+  // bring the bands into planar order
+  const byte* src = data;
+  if ((layout == h_MSI_BIT_BIP) && (n > 1)) {
+    byte* const pl = planes.get(size);
+    if (bytes == 1) {
+      h_MSI_BIT_planar<byte>(data, newsize, n, pl);
+    } else {
+      h_MSI_BIT_planar<unsigned short>((const unsigned short*)data, newsize, n, (unsigned short*)pl);
+    }
+    src = pl;
+  }
+
+  // per-band 2D DIFF, inter-band DIFF, TCMS, and bit planes
+  int shift = 0;
+  if (bytes == 1) {
+    h_MSI_BIT_bands<byte>(src, w, h, n, ref, pred, shift, &out[h_MSI_BIT_side], scratch.get(size));
+  } else {
+    shift = h_BMP_BIT_shift<unsigned short, 1>(src, size, newsize * n, 1);
+    h_MSI_BIT_bands<unsigned short>((const unsigned short*)src, w, h, n, ref, pred, shift, (unsigned short*)&out[h_MSI_BIT_side], scratch.get<unsigned short>(size));
+  }
+
+  h_BMP_BIT_set4(&out[0], w);
+  h_BMP_BIT_set4(&out[4], h);
+  h_BMP_BIT_set4(&out[8], n);
+  h_BMP_BIT_set4(&out[12], bytes);
+  h_BMP_BIT_set4(&out[16], layout);
+  h_BMP_BIT_set4(&out[20], ref + 1);
+  h_BMP_BIT_set4(&out[24], shift);
+
+  size += h_MSI_BIT_side;
+  return true;
+}
+
+
+// the restored samples replace data and live in the out arena
+static inline bool h_iMSI_BIT(int& size, byte*& data, const byte pred, h_arena& out, h_arena& planes, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  const bool side = (size >= h_MSI_BIT_side);
+  const int w = side ? h_BMP_BIT_get4(&data[0]) : 0;
+  const int h = side ? h_BMP_BIT_get4(&data[4]) : 0;
+  const int n = side ? h_BMP_BIT_get4(&data[8]) : 0;
+  const int bytes = side ? h_BMP_BIT_get4(&data[12]) : 0;
+  const int layout = side ? h_BMP_BIT_get4(&data[16]) : 0;
+  const int ref = side ? (int)((unsigned int)h_BMP_BIT_get4(&data[20]) - 1) : 0;
+  const int shift = side ? h_BMP_BIT_get4(&data[24]) : 0;
+  if ((w < 1) || (h < 1) || (n < 1) || ((bytes != 1) && (bytes != 2)) || ((layout != h_MSI_BIT_BIP) && (layout != h_MSI_BIT_BSQ)) || (ref < h_MSI_BIT_PREV) || (ref >= n) || (shift < 0) || (shift >= bytes * 8) || (h_BMP_BIT_extent(w, h, n, bytes) + h_MSI_BIT_side != size)) return false;  // not a supported multi-band image
+
+  const int newsize = w * h;
+  const int osize = size - h_MSI_BIT_side;
+  byte* const res = out.get(osize);
+  byte* const dst = ((layout == h_MSI_BIT_BIP) && (n > 1)) ? planes.get(osize) : res;
+
+  // inverse bit planes, inter-band DIFF, TCMS, and per-band 2D DIFF
+  if (bytes == 1) {
+    h_iMSI_BIT_bands<byte>(&data[h_MSI_BIT_side], w, h, n, ref, pred, shift, dst, scratch.get(osize));
+  } else {
+    h_iMSI_BIT_bands<unsigned short>((const unsigned short*)&data[h_MSI_BIT_side], w, h, n, ref, pred, shift, (unsigned short*)dst, scratch.get<unsigned short>(osize));
+  }
+
+  // restore the original sample order
+  if (dst != res) {
+    if (bytes == 1) {
+      h_MSI_BIT_interleaved<byte>(dst, newsize, n, res);
+    } else {
+      h_MSI_BIT_interleaved<unsigned short>((const unsigned short*)dst, newsize, n, (unsigned short*)res);
+    }
+  }
+
+  data = res;
+  size = osize;
+  return true;
+}
+
+
+#endif
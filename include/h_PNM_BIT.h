@@ -0,0 +1,217 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+
+#ifndef pnm_bit
+#define pnm_bit
+
+
+#include "h_BMP_BIT.h"
+
+
+// skip whitespace and comments and read a decimal number starting at data[pos]
+static inline int h_PNM_BIT_number(const byte* const data, const int size, int& pos)
+{
+  while (pos < size) {
+    if (data[pos] == '#') {
+      while ((pos < size) && (data[pos] != '\n')) pos++;
+    } else if ((data[pos] == ' ') || (data[pos] == '\t') || (data[pos] == '\n') || (data[pos] == '\r')) {
+      pos++;
+    } else {
+      break;
+    }
+  }
+  int val = -1;
+  while ((pos < size) && (data[pos] >= '0') && (data[pos] <= '9') && (val < 0x1000000)) {
+    val = ((val < 0) ? 0 : (val * 10)) + (data[pos] - '0');
+    pos++;
+  }
+  return val;
+}
+
+
+// parse a P5 (PGM), P6 (PPM), or P7 (PAM) header (data[0] is ignored because it holds the shift in transformed data)
+// and return the width, height, number of channels, maximum value, and offset of the pixel array without checking that the pixels fit in the data
+static inline bool h_PNM_BIT_fields(const byte* const data, const int size, int& w, int& h, int& C, int& maxval, int& off)
+{
+  if ((size < 3) || (data[1] < '5') || (data[1] > '7')) return false;
+  int pos = 2;
+  if (data[1] != '7') {
+    C = (data[1] == '5') ? 1 : 3;
+    w = h_PNM_BIT_number(data, size, pos);
+    h = h_PNM_BIT_number(data, size, pos);
+    maxval = h_PNM_BIT_number(data, size, pos);
+  } else {
+    // PAM header made of "KEYWORD value" lines up to ENDHDR
+    w = h = C = maxval = -1;
+    while (true) {
+      while ((pos < size) && ((data[pos] == ' ') || (data[pos] == '\t') || (data[pos] == '\n') || (data[pos] == '\r'))) pos++;
+      const char* const key = (const char*)&data[pos];
+      const int rem = size - pos;
+      if ((rem >= 7) && (strncmp(key, "ENDHDR\n", 7) == 0)) {
+        off = pos + 7;
+        break;
+      }
+      if ((rem >= 6) && (strncmp(key, "WIDTH ", 6) == 0)) {
+        pos += 5;
+        w = h_PNM_BIT_number(data, size, pos);
+      } else if ((rem >= 7) && (strncmp(key, "HEIGHT ", 7) == 0)) {
+        pos += 6;
+        h = h_PNM_BIT_number(data, size, pos);
+      } else if ((rem >= 6) && (strncmp(key, "DEPTH ", 6) == 0)) {
+        pos += 5;
+        C = h_PNM_BIT_number(data, size, pos);
+      } else if ((rem >= 7) && (strncmp(key, "MAXVAL ", 7) == 0)) {
+        pos += 6;
+        maxval = h_PNM_BIT_number(data, size, pos);
+      } else if (((rem >= 8) && (strncmp(key, "TUPLTYPE", 8) == 0)) || ((rem >= 1) && (key[0] == '#'))) {
+        while ((pos < size) && (data[pos] != '\n')) pos++;
+      } else {
+        return false;
+      }
+    }
+  }
+  if (data[1] != '7') {
+    // a single whitespace character separates the header from the pixel array
+    if ((pos >= size) || ((data[pos] != ' ') && (data[pos] != '\t') && (data[pos] != '\n') && (data[pos] != '\r'))) return false;
+    off = pos + 1;
+  }
+  return (w > 0) && (h > 0) && (C >= 1) && (C <= 4) && (maxval > 0) && (maxval < 65536);
+}
+
+
+// read a header and check that the pixel array fits in the data
+static inline bool h_PNM_BIT_header(const byte* const data, const int size, int& w, int& h, int& C, int& maxval, int& off)
+{
+  return h_PNM_BIT_fields(data, size, w, h, C, maxval, off) && (h_BMP_BIT_extent(w, h, C, (maxval < 256) ? 1 : 2) <= size - off);
+}
+
+
+// swap the bytes of num 16-bit samples (Netpbm stores them in big-endian order)
+static inline void h_PNM_BIT_swap(byte* const data, const int num)
+{
+  #pragma omp parallel for default(none) shared(data, num)
+  for (int i = 0; i < num; i++) {
+    const byte hi = data[2 * (long long)i];
+    data[2 * (long long)i] = data[2 * (long long)i + 1];
+    data[2 * (long long)i + 1] = hi;
+  }
+}
+
+
+// transform the pixel array of a binary Netpbm image from data into out, which has room for size + 1 bytes (the header and any trailing bytes are kept as is)
+// the channels are used in file order, which is fine because the color-channel DIFF treats channels 0 and 2 alike
+// 16-bit samples that start at an odd offset are realigned by prefixing the data with one byte
+static inline bool h_PNM_BIT(int& size, const byte* const data, byte* const out, byte& pred, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  int w, h, C, maxval, off;
+  if ((data[0] != 'P') || !h_PNM_BIT_header(data, size, w, h, C, maxval, off)) return false;  // not a supported PGM, PPM, or PAM image
+
+  const int base = ((maxval >= 256) && (off % 2 != 0)) ? 1 : 0;
+  out[0] = 0;
+  memcpy(&out[base], data, size);
+  size += base;
+
+  byte* const pix = &out[base + off];
+  int shift = 0;
+  if (maxval < 256) {
+    h_BMP_BIT_channels<byte>(pix, w, h, C, pred, shift, scratch);
+  } else {
+    h_PNM_BIT_swap(pix, w * h * C);
+    h_BMP_BIT_channels<unsigned short>(pix, w, h, C, pred, shift, scratch);
+  }
+  out[0] = shift + base * 16;  // the magic 'P' (or the prefix) holds the number of dropped trailing zero bits and whether there is a prefix
+  return true;
+}
+
+
+// the image is restored in place, and data then skips the prefix if there is one
+static inline bool h_iPNM_BIT(int& size, byte*& data, const byte pred, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  const int base = data[0] / 16;
+  const int shift = data[0] % 16;
+  int w, h, C, maxval, off;
+  if ((base > 1) || !h_PNM_BIT_header(&data[base], size - base, w, h, C, maxval, off) || ((base == 1) && ((maxval < 256) || (off % 2 == 0)))) return false;  // not a supported PGM, PPM, or PAM image
+
+  byte* const pix = &data[base + off];
+  if (maxval < 256) {
+    h_iBMP_BIT_channels<byte>(pix, w, h, C, pred, shift, scratch);
+  } else {
+    h_iBMP_BIT_channels<unsigned short>(pix, w, h, C, pred, shift, scratch);
+    h_PNM_BIT_swap(pix, w * h * C);
+  }
+  data[base] = 'P';
+  data += base;
+  size -= base;
+  return true;
+}
+
+
+
+// describe the pixels of a Netpbm image that has been transformed (or stored as is if transformed is false) without restoring it
+// (the 16-bit samples of stored images are aligned and swapped into native order in place)
+static inline bool h_PNM_BIT_image(byte* const data, const int size, const bool transformed, h_image& img)
+{
+  const int base = transformed ? (data[0] / 16) : 0;
+  int w, h, C, maxval, off;
+  if ((size < 1) || (base > 1) || (!transformed && (data[0] != 'P')) || !h_PNM_BIT_header(&data[base], size - base, w, h, C, maxval, off) || ((maxval >= 256) && transformed && ((base + off) % 2 != 0))) return false;
+  img.pix = &data[base + off];
+  img.planes = transformed;
+  img.w = w;
+  img.h = h;
+  img.C = C;
+  img.bytes = (maxval < 256) ? 1 : 2;
+  img.width = w * C * img.bytes;
+  img.shift = transformed ? (data[0] % 16) : 0;
+  img.maxval = maxval;
+  img.bgr = false;
+  img.bottomup = false;
+  if (!transformed && (img.bytes == 2)) {
+    if (off % 2 != 0) {
+      memmove(&img.pix[-1], img.pix, w * h * C * 2);
+      img.pix--;
+    }
+    h_PNM_BIT_swap(img.pix, w * h * C);
+  }
+  return true;
+}
+
+#endif
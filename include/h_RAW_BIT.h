@@ -0,0 +1,202 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+
+#ifndef raw_bit
+#define raw_bit
+
+
+#include "h_BMP_BIT.h"
+
+
+static const int h_RAW_BIT_side = 16;  // width, height, pixel format, and number of dropped trailing zero bits
+
+// pixel formats (the channel order does not matter to the transform, but it is recorded for the caller)
+static const int h_RAW_GRAY8 = 0;
+static const int h_RAW_RGB24 = 1;
+static const int h_RAW_BGR24 = 2;
+static const int h_RAW_RGBA32 = 3;
+static const int h_RAW_BGRA32 = 4;
+static const int h_RAW_GRAY16 = 5;
+static const int h_RAW_RGB48 = 6;
+static const int h_RAW_BGR48 = 7;
+static const int h_RAW_RGBA64 = 8;
+static const int h_RAW_formats = 9;
+
+static const byte h_RAW_channels [h_RAW_formats] = {1, 3, 3, 4, 4, 1, 3, 3, 4};
+static const byte h_RAW_bytes [h_RAW_formats] = {1, 1, 1, 1, 1, 2, 2, 2, 2};  // bytes per channel
+
+
+// number of bytes per pixel of a pixel format or 0 if the format is not supported
+static inline int h_RAW_BIT_pixel(const int fmt)
+{
+  return ((fmt < 0) || (fmt >= h_RAW_formats)) ? 0 : (h_RAW_channels[fmt] * h_RAW_bytes[fmt]);
+}
+
+
+template <typename T, int C>
+static inline void h_RAW_BIT_pixels(const byte* const pix, const int stride, const int w, const int h, byte& pred, int& shift, byte* const out, h_arena& scratch)
+{
+  const int num = w * h * C;
+  T* const tmp = scratch.get<T>((long long)num * sizeof(T));
+
+  shift = (sizeof(T) > 1) ? h_BMP_BIT_shift<T, C>(pix, stride, w, h) : 0;
+  if (pred == h_PRED_AUTO) {
+    pred = (h_BMP_BIT_cost<T, C>(pix, stride, w, h, h_PRED_XY) < h_BMP_BIT_cost<T, C>(pix, stride, w, h, h_PRED_X)) ? h_PRED_XY : h_PRED_X;
+  }
+
+  h_BMP_BIT_encode<T, C>(pix, stride, w, h, pred, shift, tmp);
+  h_BMP_BIT_BIT<T>(tmp, num, out);
+}
+
+
+template <typename T, int C>
+static inline void h_iRAW_BIT_pixels(const byte* const in, const int w, const int h, const byte pred, const int shift, byte* const pix, const int stride, h_arena& scratch)
+{
+  const int num = w * h * C;
+  T* const tmp = scratch.get<T>((long long)num * sizeof(T));
+
+  h_BMP_BIT_iBIT<T>(in, num, tmp);
+  h_BMP_BIT_decode<T, C>(tmp, w, h, pred, shift, pix, stride);
+}
+
+
+// size of the transformed data of a w x h pixel buffer whose rows start stride bytes apart or 0 if the buffer is not supported (the rows
+// may span more than 2 GB, as the transforms address them with 64-bit offsets)
+static inline int h_RAW_BIT_size(const int w, const int h, const int stride, const int fmt)
+{
+  const int ps = h_RAW_BIT_pixel(fmt);
+  if ((ps == 0) || (w < 1) || (h < 1) || ((long long)w * ps > (stride < 0 ? -(long long)stride : stride)) || (h_BMP_BIT_extent(w, h, ps) > 0x7fffffff - h_RAW_BIT_side)) return 0;  // unsupported pixel buffer
+  return h_RAW_BIT_side + w * h * ps;
+}
+
+
+// transform a w x h pixel buffer whose rows start stride bytes apart (stride may be negative for bottom-up buffers) without modifying or copying it;
+// data must hold h_RAW_BIT_size() bytes (without a predictor, the pixels are only packed behind the side information)
+static inline bool h_RAW_BIT(const byte* const pix, const int w, const int h, const int stride, const int fmt, byte& pred, byte* const data, h_arena& scratch)
+{
+  if (h_RAW_BIT_size(w, h, stride, fmt) == 0) return false;
+
+  const int bytes = w * h_RAW_BIT_pixel(fmt);
+  byte* const out = &data[h_RAW_BIT_side];
+  int shift = 0;
+  if (pred == h_PRED_NONE) {
+    #pragma omp parallel for default(none) shared(pix, h, stride, bytes, out)
+    for (int y = 0; y < h; y++) {
+      memcpy(&out[y * bytes], &pix[(long long)y * stride], bytes);
+    }
+  } else {
+    switch (fmt) {
+      case h_RAW_GRAY8: h_RAW_BIT_pixels<byte, 1>(pix, stride, w, h, pred, shift, out, scratch); break;
+      case h_RAW_RGB24: case h_RAW_BGR24: h_RAW_BIT_pixels<byte, 3>(pix, stride, w, h, pred, shift, out, scratch); break;
+      case h_RAW_RGBA32: case h_RAW_BGRA32: h_RAW_BIT_pixels<byte, 4>(pix, stride, w, h, pred, shift, out, scratch); break;
+      case h_RAW_GRAY16: h_RAW_BIT_pixels<unsigned short, 1>(pix, stride, w, h, pred, shift, out, scratch); break;
+      case h_RAW_RGB48: case h_RAW_BGR48: h_RAW_BIT_pixels<unsigned short, 3>(pix, stride, w, h, pred, shift, out, scratch); break;
+      default: h_RAW_BIT_pixels<unsigned short, 4>(pix, stride, w, h, pred, shift, out, scratch); break;
+    }
+  }
+
+  h_BMP_BIT_set4(&data[0], w);
+  h_BMP_BIT_set4(&data[4], h);
+  h_BMP_BIT_set4(&data[8], fmt);
+  h_BMP_BIT_set4(&data[12], shift);
+  return true;
+}
+
+
+// read the geometry of transformed pixel-buffer data
+static inline bool h_RAW_BIT_info(const byte* const data, const int size, int& w, int& h, int& fmt)
+{
+  w = (size < h_RAW_BIT_side) ? 0 : h_BMP_BIT_get4(&data[0]);
+  h = (size < h_RAW_BIT_side) ? 0 : h_BMP_BIT_get4(&data[4]);
+  fmt = (size < h_RAW_BIT_side) ? -1 : h_BMP_BIT_get4(&data[8]);
+  const int ps = h_RAW_BIT_pixel(fmt);
+  return (ps > 0) && (w > 0) && (h > 0) && (h_BMP_BIT_extent(w, h, ps) + h_RAW_BIT_side == size);
+}
+
+
+// restore the pixels into a caller-provided buffer whose rows start stride bytes apart (only the leading w * pixel size bytes of each row are written)
+static inline bool h_iRAW_BIT(const byte* const data, const int size, const byte pred, byte* const pix, const int stride, h_arena& scratch)
+{
+  int w, h, fmt;
+  const int shift = (size < h_RAW_BIT_side) ? -1 : h_BMP_BIT_get4(&data[12]);
+  if (!h_RAW_BIT_info(data, size, w, h, fmt) || (shift < 0) || (shift >= h_RAW_bytes[fmt] * 8) || ((long long)w * h_RAW_BIT_pixel(fmt) > (stride < 0 ? -(long long)stride : stride))) return false;  // not a supported pixel buffer
+
+  const int bytes = w * h_RAW_BIT_pixel(fmt);
+  const byte* const in = &data[h_RAW_BIT_side];
+  if (pred == h_PRED_NONE) {
+    #pragma omp parallel for default(none) shared(pix, h, stride, bytes, in)
+    for (int y = 0; y < h; y++) {
+      memcpy(&pix[(long long)y * stride], &in[y * bytes], bytes);
+    }
+  } else {
+    switch (fmt) {
+      case h_RAW_GRAY8: h_iRAW_BIT_pixels<byte, 1>(in, w, h, pred, shift, pix, stride, scratch); break;
+      case h_RAW_RGB24: case h_RAW_BGR24: h_iRAW_BIT_pixels<byte, 3>(in, w, h, pred, shift, pix, stride, scratch); break;
+      case h_RAW_RGBA32: case h_RAW_BGRA32: h_iRAW_BIT_pixels<byte, 4>(in, w, h, pred, shift, pix, stride, scratch); break;
+      case h_RAW_GRAY16: h_iRAW_BIT_pixels<unsigned short, 1>(in, w, h, pred, shift, pix, stride, scratch); break;
+      case h_RAW_RGB48: case h_RAW_BGR48: h_iRAW_BIT_pixels<unsigned short, 3>(in, w, h, pred, shift, pix, stride, scratch); break;
+      default: h_iRAW_BIT_pixels<unsigned short, 4>(in, w, h, pred, shift, pix, stride, scratch); break;
+    }
+  }
+  return true;
+}
+
+
+
+// describe the pixels of transformed (or, if transformed is false, packed) pixel-buffer data without restoring them
+static inline bool h_RAW_BIT_image(byte* const data, const int size, const bool transformed, h_image& img)
+{
+  int w, h, fmt;
+  if (!h_RAW_BIT_info(data, size, w, h, fmt)) return false;
+  img.pix = &data[h_RAW_BIT_side];
+  img.planes = transformed;
+  img.w = w;
+  img.h = h;
+  img.C = h_RAW_channels[fmt];
+  img.bytes = h_RAW_bytes[fmt];
+  img.width = w * h_RAW_BIT_pixel(fmt);
+  img.shift = h_BMP_BIT_get4(&data[12]);
+  img.maxval = (img.bytes == 1) ? 0xff : 0xffff;
+  img.bgr = (fmt == h_RAW_BGR24) || (fmt == h_RAW_BGRA32) || (fmt == h_RAW_BGR48);
+  img.bottomup = false;
+  return (img.shift >= 0) && (img.shift < img.bytes * 8);
+}
+
+#endif
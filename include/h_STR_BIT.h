@@ -0,0 +1,301 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+
+#ifndef str_bit
+#define str_bit
+
+
+#include "h_BMP_BIT.h"
+
+
+static const int h_STR_BIT_side = 12;  // record stride, element width, and number of dropped trailing zero bits
+static const int h_STR_BIT_max_stride = 256;  // largest record stride considered by the detection
+static const int h_STR_BIT_blocks = 16;  // number of sampled blocks for the detection
+static const int h_STR_BIT_block = 1024 * 16;  // largest sampled block (the blocks cover at most 1/16 of large inputs)
+static const int h_STR_BIT_min_block = 1024 * 2;  // smallest sampled block
+static const int h_STR_BIT_probes = 4;  // number of blocks of the quick probe that every stride has to pass
+static const int h_STR_BIT_probe = 1024;  // size of each probed block
+static const int h_STR_BIT_min_score = 64;  // score below which there is no periodic structure
+
+
+// size of the sampled blocks of size bytes of data
+static inline int h_STR_BIT_sample(const int size)
+{
+  return std::min(size, std::max(h_STR_BIT_min_block, std::min(h_STR_BIT_block, size / (h_STR_BIT_blocks * 16))));
+}
+
+
+// fraction of the bytes in the sampled blocks (in 1/1024) that equal the byte one stride earlier
+static inline int h_STR_BIT_score(const byte* const data, const int size, const int stride, const int block, const int blocks)
+{
+  long long same = 0, total = 0;
+  for (int b = 0; b < blocks; b++) {
+    const int beg = (int)((long long)(size - block) * b / blocks);
+    int cnt = 0;
+    for (int i = beg + stride; i < beg + block; i++) {
+      cnt += (data[i] == data[i - stride]);
+    }
+    same += cnt;
+    total += std::max(0, block - stride);
+  }
+  return (total == 0) ? 0 : (int)(same * 1024 / total);
+}
+
+
+// estimate the number of non-zero bit-plane bytes the delta of the sampled records with C fields of type T produces
+template <typename T>
+static inline long long h_STR_BIT_cost(const byte* const data, const int size, const int C)
+{
+  const int bits = sizeof(T) * 8;
+  const int stride = C * sizeof(T);
+  const int records = h_STR_BIT_sample(size) / stride;
+  long long cost = 0;
+  for (int b = 0; b < h_STR_BIT_blocks; b++) {
+    const int beg = (int)((long long)(size - records * stride) * b / h_STR_BIT_blocks) / stride * stride;
+    const h_BMP_BIT_samples<T> rec = {&data[beg]};  // records start at any byte offset
+    for (int g = 1; g <= records - bits; g += bits) {
+      for (int c = 0; c < C; c++) {
+        unsigned int o = 0;
+        for (int r = g; r < g + bits; r++) {
+          o |= h_BMP_BIT_TCMS<T>(rec[r * C + c] - rec[(r - 1) * C + c]);
+        }
+        cost += __builtin_popcount(o) * sizeof(T);
+      }
+    }
+  }
+  return cost;
+}
+
+
+// find the dominant record stride (the smallest stride that nearly reaches the best autocorrelation score) and the element width (1, 2, or 4 bytes) with the lowest estimated cost
+// (wider elements win ties within 10% because the byte-wise estimate misses the carries between the bytes of a value)
+// a quick probe of a few small blocks rules out data without structure (e.g., random or already compressed data) and the strides that cannot win before the full sample is scored
+static inline bool h_STR_BIT_detect(const byte* const data, const int size, int& stride, int& width)
+{
+  const int maxs = std::min(h_STR_BIT_max_stride, size / 4);
+  if (maxs < 1) return false;
+  const int probe = std::min(h_STR_BIT_probe, size);
+  const int block = h_STR_BIT_sample(size);
+  int score [h_STR_BIT_max_stride + 1] = {};
+  bool any = false;
+  for (int s = 1; s <= maxs; s++) {
+    score[s] = h_STR_BIT_score(data, size, s, probe, h_STR_BIT_probes);
+    any |= (score[s] * 2 >= h_STR_BIT_min_score);
+  }
+  if (!any) return false;  // no periodic structure
+  if (block > probe) {
+    #pragma omp parallel for default(none) shared(data, size, maxs, probe, block, score) schedule(dynamic, 1)
+    for (int s = 1; s <= maxs; s++) {
+      score[s] = (score[s] * 2 >= h_STR_BIT_min_score) ? h_STR_BIT_score(data, size, s, block, h_STR_BIT_blocks) : 0;
+    }
+  }
+  int best = 1;
+  for (int s = 2; s <= maxs; s++) {
+    if (score[s] > score[best]) best = s;
+  }
+  if (score[best] < h_STR_BIT_min_score) return false;  // no periodic structure
+  stride = best;
+  for (int s = 1; s < best; s++) {
+    if ((best % s == 0) && (score[s] * 20 >= score[best] * 19)) {
+      stride = s;
+      break;
+    }
+  }
+
+  width = 1;
+  long long cost = h_STR_BIT_cost<byte>(data, size, stride);
+  if (stride % 2 == 0) {
+    const long long c2 = h_STR_BIT_cost<unsigned short>(data, size, stride / 2);
+    if (c2 * 10 < cost * 11) {width = 2; cost = c2;}
+  }
+  if (stride % 4 == 0) {
+    const long long c4 = h_STR_BIT_cost<unsigned int>(data, size, stride / 4);
+    if (c4 * 10 < cost * 11) {width = 4; cost = c4;}
+  }
+  return true;
+}
+
+
+// delta of each of the C fields across consecutive records, TCMS, and separation into one plane per field
+template <typename T>
+static inline void h_STR_BIT_encode(const h_BMP_BIT_samples<T> in, const int records, const int C, const int shift, T* const __restrict__ tmp)
+{
+  #pragma omp parallel for default(none) shared(in, records, C, shift, tmp)
+  for (int beg = 0; beg < records; beg += 4096) {
+    const int end = std::min(records, beg + 4096);
+    for (int c = 0; c < C; c++) {
+      unsigned int p = (beg > 0) ? (in[(beg - 1) * C + c] >> shift) : 0;
+      for (int r = beg; r < end; r++) {
+        const unsigned int n = in[r * C + c] >> shift;
+        tmp[c * records + r] = h_BMP_BIT_TCMS<T>(n - p);
+        p = n;
+      }
+    }
+  }
+}
+
+
+// inverse delta as a parallel prefix sum: block sums, then the running offset of each block, then the blocks (sum has room for C values per block of 4096 records)
+template <typename T>
+static inline void h_STR_BIT_decode(const T* const __restrict__ tmp, const int records, const int C, const int shift, byte* const __restrict__ out, unsigned int* const sum)
+{
+  const int blocks = (records + 4095) / 4096;
+  #pragma omp parallel for default(none) shared(tmp, records, C, blocks, sum)
+  for (int b = 0; b < blocks; b++) {
+    const int end = std::min(records, (b + 1) * 4096);
+    for (int c = 0; c < C; c++) {
+      unsigned int s = 0;
+      for (int r = b * 4096; r < end; r++) s += h_BMP_BIT_iTCMS<T>(tmp[c * records + r]);
+      sum[b * C + c] = s;
+    }
+  }
+  for (int c = 0; c < C; c++) {
+    unsigned int s = 0;
+    for (int b = 0; b < blocks; b++) {
+      const unsigned int t = sum[b * C + c];
+      sum[b * C + c] = s;
+      s += t;
+    }
+  }
+  #pragma omp parallel for default(none) shared(tmp, records, C, shift, blocks, sum, out)
+  for (int b = 0; b < blocks; b++) {
+    const int end = std::min(records, (b + 1) * 4096);
+    for (int c = 0; c < C; c++) {
+      unsigned int p = sum[b * C + c];
+      for (int r = b * 4096; r < end; r++) {
+        p += h_BMP_BIT_iTCMS<T>(tmp[c * records + r]);
+        h_BMP_BIT_store<T>(&out[((long long)r * C + c) * sizeof(T)], (T)(p << shift));
+      }
+    }
+  }
+}
+
+
+template <typename T>
+static inline int h_STR_BIT_fields(const byte* const data, const int records, const int C, byte* const out, h_arena& scratch)
+{
+  const int num = records * C;
+  T* const tmp = scratch.get<T>((long long)num * sizeof(T));
+  const int shift = (sizeof(T) > 1) ? h_BMP_BIT_shift<T, 1>(data, num * sizeof(T), num, 1) : 0;
+  h_STR_BIT_encode<T>(h_BMP_BIT_samples<T>{data}, records, C, shift, tmp);
+  for (int c = 0; c < C; c++) {
+    h_BMP_BIT_BIT<T>(&tmp[c * records], records, &out[(long long)c * records * sizeof(T)]);
+  }
+  return shift;
+}
+
+
+template <typename T>
+static inline void h_iSTR_BIT_fields(const byte* const data, const int records, const int C, const int shift, byte* const out, h_arena& scratch)
+{
+  const int num = records * C;
+  const long long tsize = ((long long)num * sizeof(T) + 63) & ~63LL;  // the block sums follow the fields
+  byte* const buf = scratch.get(tsize + (long long)(records + 4095) / 4096 * C * sizeof(unsigned int));
+  T* const tmp = (T*)buf;
+  for (int c = 0; c < C; c++) {
+    h_BMP_BIT_iBIT<T>(&data[(long long)c * records * sizeof(T)], records, &tmp[c * records]);
+  }
+  h_STR_BIT_decode<T>(tmp, records, C, shift, out, (unsigned int*)&buf[tsize]);
+}
+
+
+// transform the records of stride bytes made of width-byte elements (stride 0 detects both) from data into out, which has room for h_STR_BIT_side + size bytes
+// trailing bytes that do not form a full record are kept as is, and the data grows by h_STR_BIT_side bytes
+static inline bool h_STR_BIT(int& size, const byte* const data, byte* const out, int stride, int width, byte& pred, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  if ((stride == 0) && !h_STR_BIT_detect(data, size, stride, width)) return false;  // no record structure found
+  if ((stride < 1) || ((width != 1) && (width != 2) && (width != 4)) || (stride % width != 0) || (size / stride < 2)) return false;  // records do not fit the data
+
+  const int records = size / stride;
+  const int C = stride / width;
+  const int rsize = records * stride;
+
+  int shift;
+  if (width == 1) {
+    shift = h_STR_BIT_fields<byte>(data, records, C, &out[h_STR_BIT_side], scratch);
+  } else if (width == 2) {
+    shift = h_STR_BIT_fields<unsigned short>(data, records, C, &out[h_STR_BIT_side], scratch);
+  } else {
+    shift = h_STR_BIT_fields<unsigned int>(data, records, C, &out[h_STR_BIT_side], scratch);
+  }
+  memcpy(&out[h_STR_BIT_side + rsize], &data[rsize], size - rsize);
+  pred = h_PRED_X;
+
+  h_BMP_BIT_set4(&out[0], stride);
+  h_BMP_BIT_set4(&out[4], width);
+  h_BMP_BIT_set4(&out[8], shift);
+
+  size += h_STR_BIT_side;
+  return true;
+}
+
+
+// the restored records replace data and live in the out arena
+static inline bool h_iSTR_BIT(int& size, byte*& data, const byte pred, h_arena& out, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  const int stride = (size < h_STR_BIT_side) ? 0 : h_BMP_BIT_get4(&data[0]);
+  const int width = (size < h_STR_BIT_side) ? 0 : h_BMP_BIT_get4(&data[4]);
+  const int shift = (size < h_STR_BIT_side) ? 0 : h_BMP_BIT_get4(&data[8]);
+  if ((stride < 1) || ((width != 1) && (width != 2) && (width != 4)) || (stride % width != 0) || (shift < 0) || (shift >= width * 8) || ((size - h_STR_BIT_side) / stride < 2)) return false;  // not a supported record layout
+
+  const int osize = size - h_STR_BIT_side;
+  const int records = osize / stride;
+  const int C = stride / width;
+  const int rsize = records * stride;
+  byte* const res = out.get(osize);
+
+  if (width == 1) {
+    h_iSTR_BIT_fields<byte>(&data[h_STR_BIT_side], records, C, shift, res, scratch);
+  } else if (width == 2) {
+    h_iSTR_BIT_fields<unsigned short>(&data[h_STR_BIT_side], records, C, shift, res, scratch);
+  } else {
+    h_iSTR_BIT_fields<unsigned int>(&data[h_STR_BIT_side], records, C, shift, res, scratch);
+  }
+  memcpy(&res[rsize], &data[h_STR_BIT_side + rsize], osize - rsize);
+
+  data = res;
+  size = osize;
+  return true;
+}
+
+
+#endif
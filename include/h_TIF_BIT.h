@@ -0,0 +1,323 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+
+#ifndef tif_bit
+#define tif_bit
+
+
+#include "h_BMP_BIT.h"
+
+
+static const int h_TIF_BIT_side = 16;  // size of the TIFF file, number of dropped trailing zero bits, and image width and height
+static const int h_TIF_BIT_ranges = 16;  // maximum number of header ranges that must not overlap the pixel data
+
+
+// layout of the pixel data of an uncompressed TIFF image (strips are handled as tiles that span the full width)
+struct h_TIF_BIT_layout
+{
+  bool be;  // big-endian (MM) byte order
+  int w, h;  // image width and height
+  int C;  // samples per pixel (1 to 4)
+  int bytes;  // bytes per sample (1 or 2)
+  int tw, tl;  // tile width and length (rows per strip)
+  int across;  // tiles per row of tiles
+  int count;  // number of tiles or strips
+  int offs, otype;  // position and type of the tile or strip offsets
+  int cnts, ctype;  // position and type of the tile or strip byte counts
+};
+
+
+static inline int h_TIF_BIT_get2(const byte data [], const bool be)
+{
+  return be ? ((data[0] << 8) | data[1]) : ((data[1] << 8) | data[0]);
+}
+
+
+static inline int h_TIF_BIT_get4(const byte data [], const bool be)
+{
+  const unsigned int v = be ? (((unsigned int)data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]) : (((unsigned int)data[3] << 24) | (data[2] << 16) | (data[1] << 8) | data[0]);
+  return (v > 0x7fffffff) ? -1 : (int)v;
+}
+
+
+// i-th element of an array of SHORT (3) or LONG (4) values at position pos
+static inline int h_TIF_BIT_elem(const byte* const data, const bool be, const int pos, const int type, const int i)
+{
+  return (type == 3) ? h_TIF_BIT_get2(&data[pos + i * 2], be) : h_TIF_BIT_get4(&data[pos + i * 4], be);
+}
+
+
+// position of the bytes of tile i, the bytes it holds inside the image, its rows, and its columns
+static inline void h_TIF_BIT_tile(const byte* const data, const h_TIF_BIT_layout& lo, const int i, int& pos, int& need, int& rows, int& cols)
+{
+  const int tx = i % lo.across;
+  const int ty = i / lo.across;
+  const int ps = lo.C * lo.bytes;
+  pos = h_TIF_BIT_elem(data, lo.be, lo.offs, lo.otype, i);
+  rows = std::min(lo.tl, lo.h - ty * lo.tl);
+  cols = std::min(lo.tw, lo.w - tx * lo.tw);
+  need = (rows - 1) * lo.tw * ps + cols * ps;
+}
+
+
+// parse the first IFD of a baseline TIFF file with uncompressed chunky 8-bit or 16-bit samples
+// ranges receives the parts of the file that are read to find the pixel data (these must not overlap the pixel data)
+static inline bool h_TIF_BIT_parse(const byte* const data, const int size, h_TIF_BIT_layout& lo, int ranges [h_TIF_BIT_ranges][2], int& nranges)
+{
+  if (size < 8) return false;
+  if ((data[0] == 'I') && (data[1] == 'I') && (data[2] == 42) && (data[3] == 0)) {
+    lo.be = false;
+  } else if ((data[0] == 'M') && (data[1] == 'M') && (data[2] == 0) && (data[3] == 42)) {
+    lo.be = true;
+  } else {
+    return false;
+  }
+  const int ifd = h_TIF_BIT_get4(&data[4], lo.be);
+  if ((ifd < 8) || (ifd > size - 2)) return false;
+  const int entries = h_TIF_BIT_get2(&data[ifd], lo.be);
+  if (ifd + 2 + entries * 12 + 4 > size) return false;
+  nranges = 0;
+  ranges[nranges][0] = 0;  ranges[nranges][1] = 8;  nranges++;
+  ranges[nranges][0] = ifd;  ranges[nranges][1] = ifd + 2 + entries * 12 + 4;  nranges++;
+
+  lo.w = lo.h = lo.tw = lo.tl = lo.offs = lo.cnts = -1;
+  lo.C = 1;
+  lo.bytes = 0;
+  int comp = 1, planar = 1, rps = 0x7fffffff, noffs = -1, ncnts = -1;
+  for (int e = 0; e < entries; e++) {
+    const byte* const ent = &data[ifd + 2 + e * 12];
+    const int tag = h_TIF_BIT_get2(&ent[0], lo.be);
+    const int type = h_TIF_BIT_get2(&ent[2], lo.be);
+    const int cnt = h_TIF_BIT_get4(&ent[4], lo.be);
+    if ((type != 3) && (type != 4)) continue;  // all relevant tags are SHORT or LONG
+    if ((cnt < 1) || (cnt > (size >> 2))) return false;
+    const int len = ((type == 3) ? 2 : 4) * cnt;
+    int pos = ifd + 2 + e * 12 + 8;
+    if (len > 4) {
+      pos = h_TIF_BIT_get4(&ent[8], lo.be);
+      if ((pos < 0) || (pos > size - len)) return false;
+    }
+    const int val = h_TIF_BIT_elem(data, lo.be, pos, type, 0);
+    bool used = true;
+    switch (tag) {
+      case 256: lo.w = val; break;  // ImageWidth
+      case 257: lo.h = val; break;  // ImageLength
+      case 258:  // BitsPerSample
+        for (int i = 0; i < cnt; i++) {
+          if (h_TIF_BIT_elem(data, lo.be, pos, type, i) != val) return false;
+        }
+        lo.bytes = ((val == 8) || (val == 16)) ? (val / 8) : -1;
+        break;
+      case 259: comp = val; break;  // Compression
+      case 277: lo.C = val; break;  // SamplesPerPixel
+      case 278: rps = val; break;  // RowsPerStrip
+      case 284: planar = val; break;  // PlanarConfiguration
+      case 322: lo.tw = val; break;  // TileWidth
+      case 323: lo.tl = val; break;  // TileLength
+      case 273: case 324: lo.offs = pos; lo.otype = type; noffs = cnt; break;  // StripOffsets or TileOffsets
+      case 279: case 325: lo.cnts = pos; lo.ctype = type; ncnts = cnt; break;  // StripByteCounts or TileByteCounts
+      default: used = false;
+    }
+    if (used && (len > 4)) {
+      if (nranges == h_TIF_BIT_ranges) return false;
+      ranges[nranges][0] = pos;  ranges[nranges][1] = pos + len;  nranges++;
+    }
+  }
+
+  if ((lo.w < 1) || (lo.h < 1) || (lo.C < 1) || (lo.C > 4) || (lo.bytes < 1) || (comp != 1) || ((planar != 1) && (lo.C != 1)) || (lo.offs < 0) || (noffs != ncnts)) return false;
+  if (h_BMP_BIT_extent(lo.w, lo.h, lo.C, lo.bytes) > size) return false;
+  if (lo.tw < 0) {
+    // strips
+    lo.tw = lo.w;
+    lo.tl = std::min(std::max(rps, 1), lo.h);
+  }
+  if ((lo.tw < 1) || (lo.tl < 1) || (h_BMP_BIT_extent(lo.tw, lo.tl, lo.C, lo.bytes) > size)) return false;
+  lo.across = (lo.w + lo.tw - 1) / lo.tw;
+  lo.count = lo.across * ((lo.h + lo.tl - 1) / lo.tl);
+  if (noffs != lo.count) return false;
+
+  // every tile must lie inside the file
+  for (int i = 0; i < lo.count; i++) {
+    int pos, need, rows, cols;
+    h_TIF_BIT_tile(data, lo, i, pos, need, rows, cols);
+    if ((pos < 0) || (pos > size - need) || (h_TIF_BIT_elem(data, lo.be, lo.cnts, lo.ctype, i) < need)) return false;
+  }
+  return true;
+}
+
+
+// check that the pixel data of the tiles neither overlaps itself nor the header ranges
+static inline bool h_TIF_BIT_disjoint(const byte* const data, const h_TIF_BIT_layout& lo, const int ranges [h_TIF_BIT_ranges][2], const int nranges, h_arena& scratch)
+{
+  long long* const seg = scratch.get<long long>((long long)lo.count * sizeof(long long));
+  for (int i = 0; i < lo.count; i++) {
+    int pos, need, rows, cols;
+    h_TIF_BIT_tile(data, lo, i, pos, need, rows, cols);
+    seg[i] = ((long long)pos << 32) | need;
+  }
+  std::sort(seg, seg + lo.count);
+  bool ok = true;
+  for (int i = 0; (i < lo.count) && ok; i++) {
+    const int beg = seg[i] >> 32;
+    const int end = beg + (int)(seg[i] & 0xffffffff);
+    if ((i + 1 < lo.count) && (end > (seg[i + 1] >> 32))) ok = false;
+    for (int r = 0; r < nranges; r++) {
+      if ((beg < ranges[r][1]) && (ranges[r][0] < end)) ok = false;
+    }
+  }
+  return ok;
+}
+
+
+// move the pixels of all tiles (in parallel) between the file and a contiguous image (with swap set, the 16-bit samples of big-endian files are converted to and from little-endian order)
+template <typename T>
+static inline void h_TIF_BIT_gather(const byte* const file, const h_TIF_BIT_layout& lo, const bool swap, byte* const img)
+{
+  const int ps = lo.C * sizeof(T);
+  #pragma omp parallel for default(none) shared(file, lo, swap, img, ps) schedule(dynamic, 1)
+  for (int i = 0; i < lo.count; i++) {
+    int pos, need, rows, cols;
+    h_TIF_BIT_tile(file, lo, i, pos, need, rows, cols);
+    const int x0 = (i % lo.across) * lo.tw;
+    const int y0 = (i / lo.across) * lo.tl;
+    for (int r = 0; r < rows; r++) {
+      const byte* const src = &file[pos + r * lo.tw * ps];
+      byte* const dst = &img[((long long)(y0 + r) * lo.w + x0) * ps];
+      if ((sizeof(T) == 1) || !lo.be || !swap) {
+        memcpy(dst, src, cols * ps);
+      } else {
+        for (int j = 0; j < cols * ps; j += 2) {
+          dst[j] = src[j + 1];
+          dst[j + 1] = src[j];
+        }
+      }
+    }
+  }
+}
+
+
+template <typename T>
+static inline void h_TIF_BIT_scatter(const byte* const img, const h_TIF_BIT_layout& lo, const bool swap, byte* const file)
+{
+  const int ps = lo.C * sizeof(T);
+  #pragma omp parallel for default(none) shared(file, lo, swap, img, ps) schedule(dynamic, 1)
+  for (int i = 0; i < lo.count; i++) {
+    int pos, need, rows, cols;
+    h_TIF_BIT_tile(file, lo, i, pos, need, rows, cols);
+    const int x0 = (i % lo.across) * lo.tw;
+    const int y0 = (i / lo.across) * lo.tl;
+    for (int r = 0; r < rows; r++) {
+      const byte* const src = &img[((long long)(y0 + r) * lo.w + x0) * ps];
+      byte* const dst = &file[pos + r * lo.tw * ps];
+      if ((sizeof(T) == 1) || !lo.be || !swap) {
+        memcpy(dst, src, cols * ps);
+      } else {
+        for (int j = 0; j < cols * ps; j += 2) {
+          dst[j] = src[j + 1];
+          dst[j + 1] = src[j];
+        }
+      }
+    }
+  }
+}
+
+
+// transform an uncompressed TIFF image from data into out, which has room for h_TIF_BIT_side + size bytes: the pixels of its strips or tiles are gathered into a contiguous
+// little-endian image in the image arena, which is transformed and written back over the pixel bytes of the file (the rest of the file is kept as is); the data grows by h_TIF_BIT_side bytes
+static inline bool h_TIF_BIT(int& size, const byte* const data, byte* const out, byte& pred, h_arena& image, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  h_TIF_BIT_layout lo;
+  int ranges [h_TIF_BIT_ranges][2], nranges;
+  if (!h_TIF_BIT_parse(data, size, lo, ranges, nranges) || !h_TIF_BIT_disjoint(data, lo, ranges, nranges, scratch) || (size > 0x7fffffff - h_TIF_BIT_side)) return false;  // not a supported uncompressed TIFF image
+
+  byte* const file = &out[h_TIF_BIT_side];
+  byte* const img = image.get((long long)lo.w * lo.h * lo.C * lo.bytes);
+  memcpy(file, data, size);
+
+  int shift = 0;
+  if (lo.bytes == 1) {
+    h_TIF_BIT_gather<byte>(file, lo, true, img);
+    h_BMP_BIT_channels<byte>(img, lo.w, lo.h, lo.C, pred, shift, scratch);
+    h_TIF_BIT_scatter<byte>(img, lo, false, file);
+  } else {
+    h_TIF_BIT_gather<unsigned short>(file, lo, true, img);
+    h_BMP_BIT_channels<unsigned short>(img, lo.w, lo.h, lo.C, pred, shift, scratch);
+    h_TIF_BIT_scatter<unsigned short>(img, lo, false, file);
+  }
+
+  h_BMP_BIT_set4(&out[0], size);
+  h_BMP_BIT_set4(&out[4], shift);
+  h_BMP_BIT_set4(&out[8], lo.w);
+  h_BMP_BIT_set4(&out[12], lo.h);
+
+  size += h_TIF_BIT_side;
+  return true;
+}
+
+
+static inline bool h_iTIF_BIT(int& size, byte*& data, const byte pred, h_arena& image, h_arena& scratch)
+{
+  if (pred == h_PRED_NONE) return false;
+  const int fsize = (size < h_TIF_BIT_side) ? -1 : h_BMP_BIT_get4(&data[0]);
+  const int shift = (size < h_TIF_BIT_side) ? -1 : h_BMP_BIT_get4(&data[4]);
+  h_TIF_BIT_layout lo;
+  int ranges [h_TIF_BIT_ranges][2], nranges;
+  if ((fsize != size - h_TIF_BIT_side) || (shift < 0) || !h_TIF_BIT_parse(&data[h_TIF_BIT_side], fsize, lo, ranges, nranges) || (shift >= lo.bytes * 8) || (lo.w != h_BMP_BIT_get4(&data[8])) || (lo.h != h_BMP_BIT_get4(&data[12]))) return false;  // not a supported TIFF image
+
+  // the pixels are moved back in place, and data then skips the side information
+  byte* const file = &data[h_TIF_BIT_side];
+  byte* const img = image.get((long long)lo.w * lo.h * lo.C * lo.bytes);
+  if (lo.bytes == 1) {
+    h_TIF_BIT_gather<byte>(file, lo, false, img);
+    h_iBMP_BIT_channels<byte>(img, lo.w, lo.h, lo.C, pred, shift, scratch);
+    h_TIF_BIT_scatter<byte>(img, lo, true, file);
+  } else {
+    h_TIF_BIT_gather<unsigned short>(file, lo, false, img);
+    h_iBMP_BIT_channels<unsigned short>(img, lo.w, lo.h, lo.C, pred, shift, scratch);
+    h_TIF_BIT_scatter<unsigned short>(img, lo, true, file);
+  }
+  data = file;
+  size = fsize;
+  return true;
+}
+
+
+#endif
@@ -0,0 +1,169 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+
+#ifndef vol_bit
+#define vol_bit
+
+
+#include "h_MSI_BIT.h"
+
+
+static const int h_VOL_BIT_side = 24;  // width, height, depth, bytes per sample, slab depth, and number of dropped trailing zero bits
+static const int h_VOL_BIT_slab = 16;  // default number of slices per independently decodable slab
+
+
+// volume geometry stored in the side information
+struct h_VOL_BIT_info
+{
+  int w, h, d;  // width, height, and number of slices
+  int bytes;  // bytes per voxel (1 or 2)
+  int slab;  // slices per slab (the first slice of a slab is not predicted from the previous slice)
+  int shift;  // number of dropped trailing zero bits
+};
+
+
+// read and check the side information at the start of the transformed data
+static inline bool h_VOL_BIT_read(const byte* const data, const int size, h_VOL_BIT_info& vi)
+{
+  const bool side = (size >= h_VOL_BIT_side);
+  vi.w = side ? h_BMP_BIT_get4(&data[0]) : 0;
+  vi.h = side ? h_BMP_BIT_get4(&data[4]) : 0;
+  vi.d = side ? h_BMP_BIT_get4(&data[8]) : 0;
+  vi.bytes = side ? h_BMP_BIT_get4(&data[12]) : 0;
+  vi.slab = side ? h_BMP_BIT_get4(&data[16]) : 0;
+  vi.shift = side ? h_BMP_BIT_get4(&data[20]) : 0;
+  if (vi.slab > vi.d) vi.slab = vi.d;  // a slab deeper than the volume holds all slices
+  return (vi.w > 0) && (vi.h > 0) && (vi.d > 0) && ((vi.bytes == 1) || (vi.bytes == 2)) && (vi.slab > 0) && (vi.shift >= 0) && (vi.shift < vi.bytes * 8) && (h_BMP_BIT_extent(vi.w, vi.h, vi.d, vi.bytes) <= 0x7fffffff - h_VOL_BIT_side);
+}
+
+
+// byte offset of the first slice of slab k in the transformed data (each slab occupies as many bytes as its slices)
+static inline int h_VOL_BIT_offset(const h_VOL_BIT_info& vi, const int k)
+{
+  return h_VOL_BIT_side + std::min(k * vi.slab, vi.d) * vi.w * vi.h * vi.bytes;
+}
+
+
+// transform a w x h x d volume of 1- or 2-byte voxels stored slice by slice (size must be w * h * d * bytes) in slabs of slab slices from data into out, which has room for h_VOL_BIT_side + size bytes;
+// the data grows by h_VOL_BIT_side bytes (without a predictor, the voxels are only prefixed with the side information so that slices remain addressable)
+static inline bool h_VOL_BIT(int& size, const byte* const data, byte* const out, const int w, const int h, const int d, const int bytes, const int slab, byte& pred, h_arena& scratch)
+{
+  if ((w < 1) || (h < 1) || (d < 1) || ((bytes != 1) && (bytes != 2)) || (slab < 1) || (h_BMP_BIT_extent(w, h, d, bytes) != size) || (size > 0x7fffffff - h_VOL_BIT_side)) return false;  // size does not match the geometry
+
+  h_VOL_BIT_info vi = {w, h, d, bytes, slab, 0};
+  const int slabs = (d + slab - 1) / slab;
+
+  if (pred == h_PRED_NONE) {
+    memcpy(&out[h_VOL_BIT_side], data, size);
+  } else {
+    // drop trailing zero bits and pick one predictor for the whole volume (the slices are stacked into one tall image)
+    if (bytes == 2) vi.shift = h_BMP_BIT_shift<unsigned short, 1>(data, size, size / 2, 1);
+    if (pred == h_PRED_AUTO) {
+      if (bytes == 1) {
+        pred = (h_BMP_BIT_cost<byte, 1>(data, w, w, h * d, h_PRED_XY) < h_BMP_BIT_cost<byte, 1>(data, w, w, h * d, h_PRED_X)) ? h_PRED_XY : h_PRED_X;
+      } else {
+        pred = (h_BMP_BIT_cost<unsigned short, 1>(data, w * 2, w, h * d, h_PRED_XY) < h_BMP_BIT_cost<unsigned short, 1>(data, w * 2, w, h * d, h_PRED_X)) ? h_PRED_XY : h_PRED_X;
+      }
+    }
+
+    // per-slice 2D DIFF, z DIFF of the in-slice residuals, TCMS, and bit planes of each slab (the slabs are independent, so they are processed in parallel, and a single slab is parallelized inside)
+    byte* const tmp = scratch.get(size);
+    #pragma omp parallel for default(none) shared(data, out, tmp, vi, w, h, d, bytes, slab, slabs, pred) schedule(dynamic, 1) if (slabs > 1)
+    for (int k = 0; k < slabs; k++) {
+      const int beg = h_VOL_BIT_offset(vi, k);
+      const int n = std::min(slab, d - k * slab);
+      byte p = pred;
+      if (bytes == 1) {
+        h_MSI_BIT_bands<byte>(&data[beg - h_VOL_BIT_side], w, h, n, h_MSI_BIT_PREV, p, vi.shift, &out[beg], &tmp[beg - h_VOL_BIT_side]);
+      } else {
+        h_MSI_BIT_bands<unsigned short>((const unsigned short*)&data[beg - h_VOL_BIT_side], w, h, n, h_MSI_BIT_PREV, p, vi.shift, (unsigned short*)&out[beg], (unsigned short*)&tmp[beg - h_VOL_BIT_side]);
+      }
+    }
+  }
+
+  h_BMP_BIT_set4(&out[0], w);
+  h_BMP_BIT_set4(&out[4], h);
+  h_BMP_BIT_set4(&out[8], d);
+  h_BMP_BIT_set4(&out[12], bytes);
+  h_BMP_BIT_set4(&out[16], slab);
+  h_BMP_BIT_set4(&out[20], vi.shift);
+
+  size += h_VOL_BIT_side;
+  return true;
+}
+
+
+// restore the slices of slab k from its transformed data in into dst (tmp has room for the slab)
+static inline void h_iVOL_BIT_slab(const byte* const in, const h_VOL_BIT_info& vi, const int k, const byte pred, byte* const dst, byte* const tmp)
+{
+  const int n = std::min(vi.slab, vi.d - k * vi.slab);
+  if (pred == h_PRED_NONE) {
+    memcpy(dst, in, n * vi.w * vi.h * vi.bytes);
+  } else if (vi.bytes == 1) {
+    h_iMSI_BIT_bands<byte>(in, vi.w, vi.h, n, h_MSI_BIT_PREV, pred, vi.shift, dst, tmp);
+  } else {
+    h_iMSI_BIT_bands<unsigned short>((const unsigned short*)in, vi.w, vi.h, n, h_MSI_BIT_PREV, pred, vi.shift, (unsigned short*)dst, (unsigned short*)tmp);
+  }
+}
+
+
+// the restored voxels replace data and live in the out arena
+static inline bool h_iVOL_BIT(int& size, byte*& data, const byte pred, h_arena& out, h_arena& scratch)
+{
+  h_VOL_BIT_info vi;
+  if (!h_VOL_BIT_read(data, size, vi) || (h_BMP_BIT_extent(vi.w, vi.h, vi.d, vi.bytes) + h_VOL_BIT_side != size)) return false;  // not a supported volume
+
+  const int osize = size - h_VOL_BIT_side;
+  byte* const res = out.get(osize);
+  byte* const tmp = scratch.get(osize);
+  const int slabs = (vi.d + vi.slab - 1) / vi.slab;
+  #pragma omp parallel for default(none) shared(data, vi, slabs, pred, res, tmp) schedule(dynamic, 1) if (slabs > 1)
+  for (int k = 0; k < slabs; k++) {
+    const int beg = h_VOL_BIT_offset(vi, k);
+    h_iVOL_BIT_slab(&data[beg], vi, k, pred, &res[beg - h_VOL_BIT_side], &tmp[beg - h_VOL_BIT_side]);
+  }
+
+  data = res;
+  size = osize;
+  return true;
+}
+
+
+#endif
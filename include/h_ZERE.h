@@ -0,0 +1,189 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+#ifndef zero_elimination_stage
+#define zero_elimination_stage
+
+
+#include "h_zero_elimination.h"
+#include "h_repetition_elimination.h"
+
+
+// zero elimination of the words of a ZERE stage (specialize for a word type to plug in a faster kernel, e.g., one using SIMD instructions)
+template <typename T, int CS>
+struct h_ZE_kernel
+{
+  static inline void encode(const T* const in, const int insize, T* const dataout, int& datasize, T* const bmout)
+  {
+    h_ZEencode(in, insize, dataout, datasize, bmout);
+  }
+
+  static inline bool decode(const int decsize, const T* const datain, const int datasize, const T* const bmin, T* const out)
+  {
+    return h_ZEdecode<T, true>(decsize, datain, datasize, bmin, out);
+  }
+};
+
+
+// ZERE stage on words of type T for chunks of up to CS bytes: zero elimination of the words followed by repetition elimination of the bitmap
+template <typename T, int CS>
+struct h_ZERE
+{
+  static_assert((CS % 8 == 0) && (CS <= 0x10000), "chunk sizes are multiples of 8 of at most 64 kB");
+
+  static inline bool encode(int& csize, byte in [CS], byte out [CS])
+  {
+    const int bits = sizeof(T) * 8;
+    const T* const in_t = (T*)in;  // type cast
+    T* const out_t = (T*)out;  // type cast
+    const int num = (csize / sizeof(T) + bits - 1) / bits;  // number of subchunks (rounded up)
+    const int extra = csize % sizeof(T);
+    T bitmap [CS / sizeof(T) / bits];
+    if (csize < (int)sizeof(T)) return false;
+
+    // compute bitmap and copy non-zero values
+    int pos;
+    h_ZE_kernel<T, CS>::encode(in_t, csize / sizeof(T), out_t, pos, bitmap);
+    pos *= sizeof(T);
+
+    // compress bitmap
+    const int numb = (num * sizeof(T) + 8 - 1) / 8;  // number of subchunks (rounded up)
+    int loc = CS - 4 - extra - (pos + numb);
+    if (loc <= 0) return false;
+    if (!h_REencode<byte, true>((byte*)bitmap, num * sizeof(T), &out[pos + numb], loc, &out[pos])) return false;
+    loc += pos + numb;
+
+    // copy leftover bytes at end
+    for (int i = 0; i < extra; i++) {
+      out[loc++] = in[csize - extra + i];
+    }
+
+    // record pos
+    out[loc++] = pos & 0xff;
+    out[loc++] = (pos >> 8) & 0xff;
+
+    // record csize
+    out[loc++] = csize & 0xff;
+    out[loc++] = (csize >> 8) & 0xff;
+
+    csize = loc;
+    return true;
+  }
+
+  // decode the csize bytes (at most CS) in in and return whether they form a valid encoding
+  static inline bool decode(int& csize, byte in [CS], byte out [CS])
+  {
+    // get csize
+    const int bits = sizeof(T) * 8;
+    const T* const in_t = (T*)in;  // type cast
+    T* const out_t = (T*)out;
+    const int old = csize;
+    if (old < 4) return false;
+    const int pos = (((int)in[csize - 3]) << 8) | in[csize - 4];
+    csize = (((int)in[csize - 1]) << 8) | in[csize - 2];
+    if ((CS > 0xffff) && (csize == 0)) csize = CS;  // a full 64 kB chunk wraps to 0
+    if ((csize < (int)sizeof(T)) || (csize > CS)) return false;
+    const int extra = csize % sizeof(T);  // extra bytes at end
+    T bitmap [CS / sizeof(T) / bits];
+
+    // check that the non-zero values, the bitmap, and the leftover bytes fit
+    const int num = (csize / sizeof(T) + bits - 1) / bits;  // number of subchunks (rounded up)
+    const int numb = (num * sizeof(T) + 8 - 1) / 8;  // number of subchunks (rounded up)
+    const int end = old - 4 - extra;  // end of the compressed bitmap
+    if (pos + numb > end) return false;
+
+    // decompress bitmap
+    if (!h_REdecode<byte, true>(num * sizeof(T), &in[pos + numb], end - (pos + numb), &in[pos], (byte*)bitmap)) return false;
+
+    // copy non-zero values based on bitmap
+    if (!h_ZE_kernel<T, CS>::decode(csize / sizeof(T), in_t, pos / sizeof(T), bitmap, out_t)) return false;
+
+    // copy leftover bytes
+    for (int i = 0; i < extra; i++) {
+      out[csize - extra + i] = in[end + i];
+    }
+    return true;
+  }
+};
+
+
+// chain of stages that encodes with the stages in order and decodes in reverse order by alternating between two buffers
+// (e.g., h_pipeline<h_ZERE<unsigned long long, CS>, h_ZERE<unsigned short, CS>, h_ZERE<byte, CS>>); the chain is composed at compile time,
+// so every pipeline is one function without dispatch between its stages
+template <typename... S>
+struct h_pipeline;
+
+
+template <typename S>
+struct h_pipeline<S>
+{
+  // encode the csize bytes in buf (clobbers buf and tmp) and return the buffer holding the result or nullptr if a stage does not compress
+  static inline byte* encode(int& csize, byte* const buf, byte* const tmp)
+  {
+    return S::encode(csize, buf, tmp) ? tmp : nullptr;
+  }
+
+  // decode the csize bytes in buf (clobbers buf and tmp) and return the buffer holding the result or nullptr if the data is corrupt
+  static inline byte* decode(int& csize, byte* const buf, byte* const tmp)
+  {
+    return S::decode(csize, buf, tmp) ? tmp : nullptr;
+  }
+};
+
+
+template <typename S, typename... R>
+struct h_pipeline<S, R...>
+{
+  static inline byte* encode(int& csize, byte* const buf, byte* const tmp)
+  {
+    return S::encode(csize, buf, tmp) ? h_pipeline<R...>::encode(csize, tmp, buf) : nullptr;
+  }
+
+  static inline byte* decode(int& csize, byte* const buf, byte* const tmp)
+  {
+    // the later stages leave their result in tmp if their number is odd
+    constexpr bool odd = (sizeof...(R) % 2 != 0);
+    if (h_pipeline<R...>::decode(csize, buf, tmp) == nullptr) return nullptr;
+    if (!S::decode(csize, odd ? tmp : buf, odd ? buf : tmp)) return nullptr;
+    return odd ? buf : tmp;
+  }
+};
+
+
+#endif
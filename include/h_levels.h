@@ -0,0 +1,109 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+#ifndef lico_levels
+#define lico_levels
+
+
+// input modes
+static const byte h_MODE_BMP = 0;  // BMP file
+static const byte h_MODE_F32 = 1;  // 2D field of 32-bit floats
+static const byte h_MODE_MSI = 2;  // multi-band (e.g., multispectral or hyperspectral) image
+static const byte h_MODE_VOL = 3;  // 3D volume or image stack
+static const byte h_MODE_STR = 4;  // generic binary data made of fixed-size records
+static const byte h_MODE_PNM = 5;  // binary PGM, PPM, or PAM image
+static const byte h_MODE_TIF = 6;  // uncompressed TIFF image
+static const byte h_MODE_RAW = 7;  // pixel buffer with a given pixel format and row stride
+
+// predictors of the image transform
+static const byte h_PRED_NONE = 0;  // transform not applied
+static const byte h_PRED_X = 1;  // horizontal DIFF
+static const byte h_PRED_XY = 2;  // horizontal DIFF followed by vertical DIFF (gradient)
+static const byte h_PRED_AUTO = 3;  // pick X or XY based on a sample of rows (never stored)
+
+// chunk-coding pipelines
+static const byte h_PIPE_ZE1 = 0;  // ZERE_1
+static const byte h_PIPE_ZE4_ZE1 = 1;  // ZERE_4 followed by ZERE_1
+static const byte h_PIPE_SPEC = 2;  // try every pipeline in h_spec_pipes per chunk and keep the smallest (tagged with a trailing byte)
+static const byte h_PIPE_ZE2_ZE1 = 3;  // ZERE_2 followed by ZERE_1
+
+static const byte h_spec_pipes [] = {h_PIPE_ZE4_ZE1, h_PIPE_ZE2_ZE1, h_PIPE_ZE1};
+
+// chunk sizes that the chunk kernels are compiled for (4 kB to 64 kB)
+static const int h_min_csbits = 12;
+static const int h_max_csbits = 16;
+
+
+// version of the compressed format (the decompressor rejects files with a different version)
+static const byte h_version = 1;
+
+
+// configuration stored after the original size at the start of every compressed file
+struct h_config
+{
+  byte level;
+  byte csbits;  // log2 of chunk size (from h_min_csbits to h_max_csbits)
+  byte pred;  // predictor used by the image transform
+  byte pipe;  // chunk-coding pipeline
+  byte mode;  // input mode
+  byte version;  // h_version
+  byte unused [2];
+};
+
+
+static const int h_min_level = 1;
+static const int h_max_level = 9;
+static const int h_default_level = 5;
+
+// level -> configuration (see README for the measured throughput and ratio of each level)
+static const h_config h_levels [h_max_level + 1] = {
+  {0, 0, 0, 0, 0, 0, {0, 0}},  // unused
+  {1, 14, h_PRED_NONE, h_PIPE_ZE1, h_MODE_BMP, h_version, {0, 0}},
+  {2, 14, h_PRED_NONE, h_PIPE_ZE4_ZE1, h_MODE_BMP, h_version, {0, 0}},
+  {3, 14, h_PRED_NONE, h_PIPE_SPEC, h_MODE_BMP, h_version, {0, 0}},
+  {4, 14, h_PRED_X, h_PIPE_ZE1, h_MODE_BMP, h_version, {0, 0}},
+  {5, 14, h_PRED_X, h_PIPE_ZE4_ZE1, h_MODE_BMP, h_version, {0, 0}},
+  {6, 14, h_PRED_X, h_PIPE_SPEC, h_MODE_BMP, h_version, {0, 0}},
+  {7, 14, h_PRED_AUTO, h_PIPE_ZE4_ZE1, h_MODE_BMP, h_version, {0, 0}},
+  {8, 14, h_PRED_AUTO, h_PIPE_SPEC, h_MODE_BMP, h_version, {0, 0}},
+  {9, 16, h_PRED_AUTO, h_PIPE_SPEC, h_MODE_BMP, h_version, {0, 0}}  // 64 kB chunks
+};
+
+
+#endif
@@ -86,8 +86,8 @@ static inline bool h_REencode(const T* const in, const int insize, T* const data
 }
 
 
-template <typename T>
-static inline void h_REdecode(const int decsize, const T* const datain, const T* const bmin, T* const out)  // all sizes in number of words
+template <typename T, bool check = false>
+static inline bool h_REdecode(const int decsize, const T* const datain, const int datasize, const T* const bmin, T* const out)  // all sizes in number of words
 {
   const int bits = sizeof(T) * 8;  // bits per word
   const int num = (decsize + bits - 1) / bits;  // number of subchunks (rounded up)
@@ -98,6 +98,9 @@ static inline void h_REdecode(const int decsize, const T* const datain, const T*
     const T bm = bmin[i];
     for (int j = 0; j < bits; j++) {
       if (((bm >> j) & 1) != 0) {
+        if constexpr (check) {
+          if (pos >= datasize) return false;
+        }
         val = datain[pos++];
       }
       out[cnt++] = val;
@@ -108,12 +111,16 @@ static inline void h_REdecode(const int decsize, const T* const datain, const T*
     const T bm = bmin[i];
     for (int j = 0; j < bits; j++) {
       if (((bm >> j) & 1) != 0) {
+        if constexpr (check) {
+          if (pos >= datasize) return false;
+        }
         val = datain[pos++];
       }
       out[cnt++] = val;
       if (cnt >= decsize) break;
     }
   }
+  return true;
 }
 
 
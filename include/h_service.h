@@ -0,0 +1,382 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+
+#ifndef lico_service
+#define lico_service
+
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include "lico.h"
+
+
+// wire protocol of the LICO daemon: a connection carries any number of requests, each answered by one response before the next is read
+
+// operations
+static const int h_service_compress = 0;
+static const int h_service_decompress = 1;
+static const int h_service_attach = 2;  // hand a shared-memory ring (the attached descriptor) to the daemon for the rest of the connection
+
+// request: the files are passed as two descriptors in the ancillary data, named by paths that follow the request (only honored for clients of the
+// daemon's own user on a Unix socket), or replaced by data bytes of input that follow the request (the only choice over TCP)
+struct h_request
+{
+  int op;  // operation
+  int paths;  // length of both paths including their terminators or 0
+  int data;  // bytes of input that follow the request (and of output that follow the response) or 0
+  lico_params params;  // compression parameters
+};
+
+// response (followed by the output if the input was sent inline and the request succeeded)
+struct h_response
+{
+  int result;  // size written to the output or error code
+};
+
+
+// shared-memory transport: the client creates a ring of slots in a memfd and attaches it to a connection, after which requests are posted by
+// placing the input into a slot and the daemon writes the output into the same slot, so the data never passes through the socket
+
+static const int h_ring_magic = 0x4f43494c;  // "LICO"
+
+// states of a slot
+static const int h_slot_free = 0;  // owned by the client
+static const int h_slot_posted = 1;  // request waiting for the daemon
+static const int h_slot_busy = 2;  // request being processed
+static const int h_slot_done = 3;  // result waiting for the client
+
+// ring header (followed by the slots)
+struct alignas(64) h_ring_head
+{
+  int magic;
+  int slots;  // number of slots
+  int incap, outcap;  // capacity of the input and output area of each slot
+  int doorbell;  // incremented (and woken) by the client whenever it posts a request
+};
+
+// slot header (followed by the input area and the output area)
+struct alignas(64) h_slot
+{
+  int state;  // ownership of the slot
+  int op;  // operation
+  int size;  // input bytes
+  int result;  // size written to the output area or error code
+  lico_params params;  // compression parameters
+};
+
+
+// seals that keep the size of a ring fixed once it is attached
+static const int h_ring_seals = F_SEAL_SHRINK | F_SEAL_GROW;
+
+
+// bytes of one slot with the given capacities
+static inline long long h_ring_stride(const int incap, const int outcap)
+{
+  return sizeof(h_slot) + ((incap + 63LL) & ~63LL) + ((outcap + 63LL) & ~63LL);
+}
+
+
+// bytes of a ring with the given slot geometry or -1 if it is too large
+static inline long long h_ring_bytes(const int slots, const int incap, const int outcap)
+{
+  if ((slots < 1) || (slots > 4096) || (incap < 1) || (outcap < 1)) return -1;
+  return sizeof(h_ring_head) + slots * h_ring_stride(incap, outcap);
+}
+
+
+// the slot addresses are computed from a copy of the geometry, never from the header, which the other process can overwrite at any time
+static inline h_slot* h_ring_slot(h_ring_head* const head, const int incap, const int outcap, const int s)
+{
+  return (h_slot*)((byte*)&head[1] + s * h_ring_stride(incap, outcap));
+}
+
+
+static inline byte* h_ring_input(h_ring_head* const head, const int incap, const int outcap, const int s)
+{
+  return (byte*)&h_ring_slot(head, incap, outcap, s)[1];
+}
+
+
+static inline byte* h_ring_output(h_ring_head* const head, const int incap, const int outcap, const int s)
+{
+  return &h_ring_input(head, incap, outcap, s)[(incap + 63LL) & ~63LL];
+}
+
+
+// sleep until the shared word no longer holds val, a wake-up arrives, or ms milliseconds pass (negative waits forever)
+static inline void h_futex_wait(int* const addr, const int val, const int ms)
+{
+  timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+  syscall(SYS_futex, addr, FUTEX_WAIT, val, (ms < 0) ? nullptr : &ts, nullptr, 0);
+}
+
+
+// wake all processes sleeping on the shared word
+static inline void h_futex_wake(int* const addr)
+{
+  syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+
+// send exactly size bytes and return whether they were sent
+static inline bool h_send(const int fd, const void* const buf, const long long size)
+{
+  const char* const p = (const char*)buf;
+  long long done = 0;
+  while (done < size) {
+    const ssize_t n = send(fd, &p[done], size - done, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+
+// receive exactly size bytes and return whether they arrived
+static inline bool h_recv(const int fd, void* const buf, const long long size)
+{
+  char* const p = (char*)buf;
+  long long done = 0;
+  while (done < size) {
+    const ssize_t n = recv(fd, &p[done], size - done, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+
+// send size bytes with count descriptors attached to the first byte and return whether they were sent
+static inline bool h_send_fds(const int fd, const void* const buf, const int size, const int* const fds, const int count)
+{
+  char ctl [CMSG_SPACE(2 * sizeof(int))];
+  memset(ctl, 0, sizeof(ctl));
+  iovec iov = {(void*)buf, 1};
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  if (count > 0) {
+    msg.msg_control = ctl;
+    msg.msg_controllen = CMSG_SPACE(count * sizeof(int));
+    cmsghdr* const cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(count * sizeof(int));
+    memcpy(CMSG_DATA(cm), fds, count * sizeof(int));
+  }
+  ssize_t n;
+  do {
+    n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+  } while (n < 0 && errno == EINTR);
+  return (n == 1) && h_send(fd, &((const char*)buf)[1], size - 1);
+}
+
+
+// receive size bytes and up to two descriptors attached to the first byte (fds is set to -1 where none arrived) and return whether the bytes arrived
+static inline bool h_recv_fds(const int fd, void* const buf, const int size, int fds [2])
+{
+  char ctl [CMSG_SPACE(2 * sizeof(int))];
+  iovec iov = {buf, 1};
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctl;
+  msg.msg_controllen = sizeof(ctl);
+  fds[0] = fds[1] = -1;
+  ssize_t n;
+  do {
+    n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+  } while (n < 0 && errno == EINTR);
+  if (n != 1) return false;
+  for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+    if ((cm->cmsg_level == SOL_SOCKET) && (cm->cmsg_type == SCM_RIGHTS)) {
+      const int count = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (int i = 0; i < count; i++) {
+        int d;
+        memcpy(&d, &CMSG_DATA(cm)[i * sizeof(int)], sizeof(int));
+        if (i < 2) fds[i] = d; else close(d);
+      }
+    }
+  }
+  return h_recv(fd, &((char*)buf)[1], size - 1);
+}
+
+
+// fill in the socket address of a Unix socket path or of "tcp:PORT" on the loopback interface and return its length (0 if invalid)
+static inline socklen_t h_address(const char* const name, sockaddr_storage& addr)
+{
+  memset(&addr, 0, sizeof(addr));
+  int port;
+  if (sscanf(name, "tcp:%d", &port) == 1) {
+    sockaddr_in* const in = (sockaddr_in*)&addr;
+    in->sin_family = AF_INET;
+    in->sin_port = htons(port);
+    in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return ((port > 0) && (port < 65536)) ? sizeof(sockaddr_in) : 0;
+  }
+  sockaddr_un* const un = (sockaddr_un*)&addr;
+  if (strlen(name) >= sizeof(un->sun_path)) return 0;
+  un->sun_family = AF_UNIX;
+  strcpy(un->sun_path, name);
+  return sizeof(sockaddr_un);
+}
+
+
+
+// connect to the daemon at a Unix socket path or "tcp:PORT" and return the socket or -1
+static inline int h_connect(const char* const name)
+{
+  sockaddr_storage addr;
+  const socklen_t len = h_address(name, addr);
+  if (len == 0) return -1;
+  const int sock = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if ((sock >= 0) && (connect(sock, (sockaddr*)&addr, len) != 0)) {
+    close(sock);
+    return -1;
+  }
+  return sock;
+}
+
+
+// client end of a shared-memory ring
+struct h_ring
+{
+  int sock;  // connection that the ring is attached to
+  h_ring_head* head;  // mapped ring
+  long long bytes;  // size of the mapping
+  int slots, incap, outcap;  // slot geometry
+};
+
+
+// create a ring with the given slot geometry, attach it to a new connection to the daemon, and return whether the daemon accepted it
+static inline bool h_ring_attach(const char* const name, const int slots, const int incap, const int outcap, h_ring& ring)
+{
+  ring.sock = -1;
+  ring.head = nullptr;
+  ring.bytes = h_ring_bytes(slots, incap, outcap);
+  ring.slots = slots;
+  ring.incap = incap;
+  ring.outcap = outcap;
+  if (ring.bytes < 0) return false;
+  const int fd = memfd_create("lico-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) return false;
+
+  // the daemon only accepts a ring whose size is sealed
+  const bool sized = (ftruncate(fd, ring.bytes) == 0) && (fcntl(fd, F_ADD_SEALS, h_ring_seals) == 0);
+  void* const mem = sized ? mmap(nullptr, ring.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+  if (mem == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  ring.head = (h_ring_head*)mem;
+  ring.head->magic = h_ring_magic;
+  ring.head->slots = slots;
+  ring.head->incap = incap;
+  ring.head->outcap = outcap;
+
+  // hand the ring to the daemon
+  h_request req;
+  memset(&req, 0, sizeof(req));
+  req.op = h_service_attach;
+  h_response res;
+  ring.sock = h_connect(name);
+  const bool ok = (ring.sock >= 0) && h_send_fds(ring.sock, &req, sizeof(req), &fd, 1) && h_recv(ring.sock, &res, sizeof(res)) && (res.result == 0);
+  close(fd);
+  return ok;
+}
+
+
+// post the size bytes in the input area of slot s
+static inline void h_ring_post(h_ring& ring, const int s, const int op, const int size, const lico_params* const params)
+{
+  h_slot* const slot = h_ring_slot(ring.head, ring.incap, ring.outcap, s);
+  slot->op = op;
+  slot->size = size;
+  memset(&slot->params, 0, sizeof(slot->params));
+  if (params != nullptr) slot->params = *params;
+  __atomic_store_n(&slot->state, h_slot_posted, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&ring.head->doorbell, 1, __ATOMIC_RELEASE);
+  h_futex_wake(&ring.head->doorbell);
+}
+
+
+// block until the request in slot s has completed, free the slot, and return the result (the output is in the output area of the slot) or
+// LICO_ERROR_ARGUMENT if the daemon has gone away
+static inline int h_ring_wait(h_ring& ring, const int s)
+{
+  h_slot* const slot = h_ring_slot(ring.head, ring.incap, ring.outcap, s);
+  int state;
+  while ((state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE)) != h_slot_done) {
+    h_futex_wait(&slot->state, state, 100);
+    pollfd pfd = {ring.sock, POLLIN, 0};
+    if ((state == __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE)) && (poll(&pfd, 1, 0) != 0)) return LICO_ERROR_ARGUMENT;
+  }
+  slot->state = h_slot_free;
+  return slot->result;
+}
+
+
+// disconnect from the daemon, which finishes the running requests before releasing the ring, and unmap the ring
+static inline void h_ring_detach(h_ring& ring)
+{
+  if (ring.sock >= 0) close(ring.sock);
+  if (ring.head != nullptr) munmap(ring.head, ring.bytes);
+  ring.sock = -1;
+  ring.head = nullptr;
+}
+
+
+#endif
@@ -0,0 +1,158 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+
+#ifndef lico_target
+#define lico_target
+
+
+#include <type_traits>
+
+
+// targets that the inverse image transforms hand their rows to (see h_iBMP_BIT_image), so that images are decoded straight into the
+// layout the caller needs instead of being restored in their file layout first
+
+
+// tensor of w x h pixels with C channels of type O in NHWC (interleaved) or NCHW (planar) order with top-down rows
+template <typename O>
+struct h_tensor
+{
+  O* dst;  // first element
+  int w, h;  // size
+  bool planar;  // NCHW instead of NHWC
+  bool flip;  // the rows arrive bottom-up
+  int map [4];  // tensor channel of each image channel
+  float scale [4], bias [4];  // floats are sample * scale + bias (per tensor channel)
+
+  template <typename T, int C>
+  void put(const int y, const h_BMP_BIT_samples<T> row) const
+  {
+    const int r = flip ? (h - 1 - y) : y;
+    for (int c = 0; c < C; c++) {
+      const int k = map[c];
+      O* const out = planar ? &dst[((long long)k * h + r) * w] : &dst[(long long)r * w * C + k];
+      const int step = planar ? 1 : C;
+      if constexpr (std::is_floating_point<O>::value) {
+        const float a = scale[k];
+        const float b = bias[k];
+        for (int x = 0; x < w; x++) out[x * step] = row[x * C + c] * a + b;
+      } else {
+        for (int x = 0; x < w; x++) out[x * step] = (O)row[x * C + c];
+      }
+    }
+  }
+};
+
+
+// pixels with D channels of type T per pixel and rows that start stride bytes apart, either interleaved or as D planes that start plane bytes apart
+struct h_pixels
+{
+  byte* dst;  // first row (of the first plane)
+  int w, h;  // size
+  long long stride;  // bytes from one row to the next
+  long long plane;  // bytes from one plane to the next
+  bool planar;  // one plane per channel
+  bool flip;  // the rows arrive in the opposite vertical order
+  int D;  // channels per pixel
+  int src [4];  // image channel of each pixel channel or -1 for the alpha fill
+  int alpha;  // value of the alpha fill
+
+  template <typename T, int C>
+  void put(const int y, const h_BMP_BIT_samples<T> row) const
+  {
+    const int r = flip ? (h - 1 - y) : y;
+    if (planar) {
+      for (int d = 0; d < D; d++) {
+        T* const out = (T*)&dst[d * plane + r * stride];
+        const int c = src[d];
+        if (c < 0) {
+          for (int x = 0; x < w; x++) out[x] = (T)alpha;
+        } else {
+          for (int x = 0; x < w; x++) out[x] = row[x * C + c];
+        }
+      }
+    } else {
+      T* const out = (T*)&dst[r * stride];
+      if ((D == C) && (src[0] == 0) && (src[D - 1] == D - 1)) {
+        for (int i = 0; i < w * C; i++) out[i] = row[i];
+      } else {
+        for (int d = 0; d < D; d++) {
+          const int c = src[d];
+          if (c < 0) {
+            for (int x = 0; x < w; x++) out[x * D + d] = (T)alpha;
+          } else {
+            for (int x = 0; x < w; x++) out[x * D + d] = row[x * C + c];
+          }
+        }
+      }
+    }
+  }
+};
+
+
+// channel of each of the C image channels in the requested order (color channels are swapped if the image has the other order, alpha stays last)
+static inline void h_target_map(const int C, const bool bgr, const bool want_bgr, int map [4])
+{
+  for (int c = 0; c < 4; c++) map[c] = c;
+  if ((C >= 3) && (bgr != want_bgr)) {
+    map[0] = 2;
+    map[2] = 0;
+  }
+}
+
+
+// image channel of each of the D pixel channels (gray is replicated into the color channels and a missing alpha channel is filled in);
+// return false if a color image would have to be converted to gray
+static inline bool h_target_source(const int C, const bool bgr, const int D, const bool want_bgr, int src [4])
+{
+  const bool gray = (C <= 2);  // gray or gray with alpha
+  if ((D == 1) && !gray) return false;
+  for (int d = 0; d < 3; d++) {
+    src[d] = gray ? 0 : d;
+  }
+  if (!gray && (bgr != want_bgr)) {
+    src[0] = 2;
+    src[2] = 0;
+  }
+  src[3] = ((C == 2) || (C == 4)) ? (C - 1) : -1;
+  return true;
+}
+
+
+#endif
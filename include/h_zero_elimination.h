@@ -83,8 +83,8 @@ static inline bool h_ZEencode(const T* const in, const int insize, T* const data
 }
 
 
-template <typename T>
-static inline void h_ZEdecode(const int decsize, const T* const datain, const T* const bmin, T* const out)  // all sizes in number of words
+template <typename T, bool check = false>
+static inline bool h_ZEdecode(const int decsize, const T* const datain, const int datasize, const T* const bmin, T* const out)  // all sizes in number of words
 {
   const int bits = sizeof(T) * 8;  // bits per word
   const int num = (decsize + bits - 1) / bits;  // number of subchunks (rounded up)
@@ -95,6 +95,9 @@ static inline void h_ZEdecode(const int decsize, const T* const datain, const T*
     for (int j = 0; j < bits; j++) {
       T val = 0;
       if (((bm >> j) & 1) != 0) {
+        if constexpr (check) {
+          if (pos >= datasize) return false;
+        }
         val = datain[pos++];
       }
       out[cnt++] = val;
@@ -106,12 +109,16 @@ static inline void h_ZEdecode(const int decsize, const T* const datain, const T*
     for (int j = 0; j < bits; j++) {
       T val = 0;
       if (((bm >> j) & 1) != 0) {
+        if constexpr (check) {
+          if (pos >= datasize) return false;
+        }
         val = datain[pos++];
       }
       out[cnt++] = val;
       if (cnt >= decsize) break;
     }
   }
+  return true;
 }
 
 
@@ -0,0 +1,288 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+
+#ifndef lico_h
+#define lico_h
+
+
+// public interface of liblico (only this header is needed to use the library)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LICO_API __attribute__((visibility("default")))
+
+#define LICO_VERSION_MAJOR 1
+#define LICO_VERSION_MINOR 1
+
+// compression levels
+#define LICO_MIN_LEVEL 1
+#define LICO_MAX_LEVEL 9
+#define LICO_DEFAULT_LEVEL 5
+
+// error codes (all functions that return a size return one of these negative values on failure)
+#define LICO_ERROR_ARGUMENT -1  // invalid argument
+#define LICO_ERROR_CAPACITY -2  // destination buffer is too small
+#define LICO_ERROR_CORRUPT -3  // compressed data is malformed
+#define LICO_ERROR_MODE -4  // compressed data does not support the requested operation
+#define LICO_ERROR_MEMORY -5  // scratch or output memory could not be allocated
+
+// input modes
+#define LICO_MODE_AUTO 0  // BMP, PGM/PPM/PAM, and TIFF images are detected, other data is searched for fixed-size records
+#define LICO_MODE_F32 1  // 2D field of 32-bit floats (width, height)
+#define LICO_MODE_MSI 2  // multi-band image (width, height, depth = bands, bytes, planar, ref)
+#define LICO_MODE_VOL 3  // volume (width, height, depth = slices, bytes, slab)
+#define LICO_MODE_STR 4  // fixed-size records (stride, element; a stride of 0 detects both)
+#define LICO_MODE_RAW 5  // packed pixels (width, height, format)
+
+// modes that lico_get_frame_info reports for data compressed with LICO_MODE_AUTO
+#define LICO_MODE_STORE 6  // stored without a transform
+#define LICO_MODE_BMP 7
+#define LICO_MODE_PNM 8
+#define LICO_MODE_TIF 9
+
+// pixel formats
+#define LICO_FORMAT_GRAY8 0
+#define LICO_FORMAT_RGB24 1
+#define LICO_FORMAT_BGR24 2
+#define LICO_FORMAT_RGBA32 3
+#define LICO_FORMAT_BGRA32 4
+#define LICO_FORMAT_GRAY16 5
+#define LICO_FORMAT_RGB48 6
+#define LICO_FORMAT_BGR48 7
+#define LICO_FORMAT_RGBA64 8
+
+// tensor layouts
+#define LICO_LAYOUT_NHWC 0  // height x width x channels
+#define LICO_LAYOUT_NCHW 1  // channels x height x width
+
+// tensor element types
+#define LICO_TYPE_UINT 0  // samples as stored (uint8, or uint16 for images with 16-bit samples)
+#define LICO_TYPE_FLOAT 1  // 32-bit floats (sample / largest sample value - mean) / std
+
+// channel orders (alpha stays last)
+#define LICO_ORDER_RGB 0
+#define LICO_ORDER_BGR 1
+
+// inter-band predictor of multi-band images that predicts each band from the previous band
+#define LICO_REF_PREV -1
+
+
+// compression parameters (zero-initialize and set the fields the mode uses)
+typedef struct lico_params
+{
+  int level;  // compression level (0 selects the default)
+  int mode;  // input mode
+  int width, height, depth;  // geometry
+  int bytes;  // bytes per sample of multi-band images and volumes (1 or 2, 0 selects 1)
+  int planar;  // multi-band samples are stored band by band instead of interleaved by pixel
+  int ref;  // reference band or LICO_REF_PREV
+  int slab;  // slices per independently decodable slab of a volume (0 selects 16)
+  int stride, element;  // record size and element width (1, 2, or 4 bytes) of fixed-size records
+  int format;  // pixel format
+  int chunk;  // chunk size in kB (4, 8, 16, 32, or 64; 0 selects the chunk size of the level)
+} lico_params;
+
+
+// description of compressed data
+typedef struct lico_frame_info
+{
+  int size;  // decompressed size (pixel buffers report the size of the packed pixels)
+  int mode;  // input mode
+  int level;  // compression level
+  int chunks;  // number of independently coded chunks
+  int width, height, depth;  // geometry (records report the stride as width and the number of records as height; unused dimensions are 0)
+  int bytes;  // bytes per sample (element width of records)
+  int format;  // pixel format of pixel buffers or -1
+  int channels;  // channels per pixel of BMP, Netpbm, and pixel-buffer images or 0
+} lico_frame_info;
+
+
+// layout of a decoded image tensor
+typedef struct lico_tensor
+{
+  int layout;  // tensor layout
+  int type;  // element type
+  int order;  // order of the color channels
+  float mean [4], std [4];  // normalization of float tensors per tensor channel (a std of 0 selects 1)
+} lico_tensor;
+
+
+// destination of a decoded image in a pixel format of the caller's choosing
+typedef struct lico_view
+{
+  int format;  // pixel format (with as many bytes per sample as the image)
+  int stride;  // bytes from the start of one row to the next (0 selects packed rows)
+  int planar;  // store one plane of height rows per channel instead of interleaved pixels (planes follow one another)
+  int flip;  // store the rows bottom-up
+  int alpha;  // alpha value of formats with alpha when the image has none
+  int x, y;  // pixel position of the image in a larger canvas that dst points to
+  int plane;  // bytes from the start of one plane to the next (0 selects stride * (y + height of the image))
+} lico_view;
+
+
+// compress srcsize bytes at src into dst and return the compressed size
+LICO_API int lico_compress(const void* src, int srcsize, void* dst, int dstcap, int level);
+
+// same as lico_compress with explicit parameters (params may be null for the defaults)
+LICO_API int lico_compress_params(const void* src, int srcsize, void* dst, int dstcap, const lico_params* params);
+
+// compress a width x height pixel buffer whose rows start stride bytes apart (negative for bottom-up buffers) without copying it
+LICO_API int lico_compress_pixels(const void* pix, int width, int height, int stride, int format, void* dst, int dstcap, int level);
+
+// upper bound on the compressed size of size bytes of input with the given parameters (params may be null for the defaults; pixel buffers pass width * height * pixel size)
+LICO_API int lico_compress_bound(int size, const lico_params* params);
+
+// describe srcsize bytes of compressed data by reading its header and, for modes that keep their geometry there, its first chunk (returns 0 on success)
+LICO_API int lico_get_frame_info(const void* src, int srcsize, lico_frame_info* info);
+
+// decompress srcsize bytes at src into dst and return the decompressed size
+LICO_API int lico_decompress(const void* src, int srcsize, void* dst, int dstcap);
+
+// decompress data produced by lico_compress_pixels into a pixel buffer whose rows start stride bytes apart (only the pixel bytes of each row are written)
+LICO_API int lico_decompress_pixels(const void* src, int srcsize, void* pix, int stride);
+
+// decompress slices first to last - 1 of a compressed volume into dst (only the chunks that hold these slices are decoded)
+LICO_API int lico_decompress_slices(const void* src, int srcsize, int first, int last, void* dst, int dstcap);
+
+// decompress a BMP (8-bit gray, 24, 32, or 48 bits per pixel), PGM/PPM/PAM, or pixel-buffer image straight into a tensor with top-down rows
+// and the width, height, and channels reported by lico_get_frame_info (each row goes into the tensor while the inverse transform still has it
+// in cache, so the image is never restored in its file layout) and return the bytes written; return LICO_ERROR_MODE for other data
+LICO_API int lico_decompress_tensor(const void* src, int srcsize, void* dst, int dstcap, const lico_tensor* tensor);
+
+// decompress the same images as lico_decompress_tensor straight into pixels laid out as described by view (gray images fill all color channels,
+// color images cannot be stored as gray) and return the bytes from dst to the end of the last row written; only the pixels of the image are
+// written, so images can be decoded concurrently (with separate contexts) into disjoint rectangles of one canvas
+LICO_API int lico_decompress_view(const void* src, int srcsize, void* dst, int dstcap, const lico_view* view);
+
+// contexts own scratch space that grows to the largest data seen and is reused by every call made with them, so repeatedly compressing
+// or decompressing BMP images or pixel buffers of the same size does not allocate memory (a context must not be used by two calls at once)
+typedef struct LICO_CCtx LICO_CCtx;
+typedef struct LICO_DCtx LICO_DCtx;
+
+// create and free contexts (create returns null if out of memory)
+LICO_API LICO_CCtx* lico_create_cctx(void);
+LICO_API void lico_free_cctx(LICO_CCtx* cctx);
+LICO_API LICO_DCtx* lico_create_dctx(void);
+LICO_API void lico_free_dctx(LICO_DCtx* dctx);
+
+// same as lico_compress_params, lico_compress_pixels, lico_decompress, lico_decompress_pixels, lico_decompress_slices, lico_decompress_tensor, and lico_decompress_view with a context
+LICO_API int lico_compress_cctx(LICO_CCtx* cctx, const void* src, int srcsize, void* dst, int dstcap, const lico_params* params);
+LICO_API int lico_compress_pixels_cctx(LICO_CCtx* cctx, const void* pix, int width, int height, int stride, int format, void* dst, int dstcap, int level);
+LICO_API int lico_decompress_dctx(LICO_DCtx* dctx, const void* src, int srcsize, void* dst, int dstcap);
+LICO_API int lico_decompress_pixels_dctx(LICO_DCtx* dctx, const void* src, int srcsize, void* pix, int stride);
+LICO_API int lico_decompress_slices_dctx(LICO_DCtx* dctx, const void* src, int srcsize, int first, int last, void* dst, int dstcap);
+LICO_API int lico_decompress_tensor_dctx(LICO_DCtx* dctx, const void* src, int srcsize, void* dst, int dstcap, const lico_tensor* tensor);
+LICO_API int lico_decompress_view_dctx(LICO_DCtx* dctx, const void* src, int srcsize, void* dst, int dstcap, const lico_view* view);
+
+// a reader serves rows of a compressed file on demand: the file is mapped, only the independently decodable segments that hold the requested
+// rows are decoded (the chunks of untransformed images, the slabs of volumes, or the whole image otherwise), and decoded segments are kept
+// in an LRU cache while worker threads decode the segments that follow in the direction of the reads (a reader must not be used by two calls at once)
+typedef struct LICO_Reader LICO_Reader;
+
+// open the compressed file at path with a cache budget in bytes (0 selects 256 MB) and the given number of prefetching threads (0 disables
+// prefetching) and return 0 or an error code; the rows are the top-down pixel rows of BMP, Netpbm, and pixel-buffer images (with the
+// channels in the order of the image and the samples in native byte order), the rows of all slices of volumes, and the rows of 2D float fields
+LICO_API int lico_open_reader(const char* path, long long budget, int threads, LICO_Reader** reader);
+LICO_API void lico_close_reader(LICO_Reader* reader);
+
+// number of rows, pixels per row, and bytes per pixel of a reader (pointers may be null)
+LICO_API int lico_reader_rows(const LICO_Reader* reader, int* rows, int* width, int* pixel);
+
+// copy count rows starting at row first into dst and return the bytes written
+LICO_API int lico_read_rows(LICO_Reader* reader, int first, int count, void* dst, int dstcap);
+
+// copy the width x height pixels at (x, y) into dst with rows that start stride bytes apart and return the bytes of pixels written (tiles of
+// 2 GB or more are rejected with LICO_ERROR_ARGUMENT)
+LICO_API int lico_read_tile(LICO_Reader* reader, int x, int y, int width, int height, void* dst, int stride);
+
+// one image of a batch: the source, destination, and parameters (null for the defaults, unused by decompression) of one call and its result
+typedef struct lico_batch_item
+{
+  const void* src;
+  int srcsize;
+  void* dst;
+  int dstcap;
+  const lico_params* params;
+  int result;  // compressed or decompressed size or error code
+} lico_batch_item;
+
+// compress or decompress count independent items by transforming them concurrently and processing the chunks of all of them from one shared
+// queue, which keeps all cores busy on batches of small images; return 0 if every item succeeded and the first error code otherwise
+LICO_API int lico_compress_batch(lico_batch_item* items, int count);
+LICO_API int lico_decompress_batch(lico_batch_item* items, int count);
+
+// an executor runs submitted jobs on its own thread and OpenMP team: jobs with many chunks are parallelized internally one after another,
+// and jobs with few chunks are packed so that each one runs on a single core next to the others; every job is released by exactly one
+// call to lico_job_wait, which returns its result (the source and destination buffers must stay valid until the job has completed)
+typedef struct LICO_Executor LICO_Executor;
+typedef struct LICO_Job LICO_Job;
+
+// called on an executor thread with the result of a job once it has completed (lico_job_wait may be called from here and does not block)
+typedef void (*lico_callback)(int result, void* user);
+
+// create an executor with the given number of threads (0 uses all cores) and free it after running the jobs that are still queued
+LICO_API LICO_Executor* lico_create_executor(int threads);
+LICO_API void lico_free_executor(LICO_Executor* executor);
+
+// file descriptor (an eventfd on Linux, -1 elsewhere) that becomes readable when jobs complete; reading it returns the number of completions since the last read
+LICO_API int lico_executor_fd(LICO_Executor* executor);
+
+// queue a job with the arguments of lico_compress_params or lico_decompress (callback may be null); return null if out of memory
+LICO_API LICO_Job* lico_submit_compress(LICO_Executor* executor, const void* src, int srcsize, void* dst, int dstcap, const lico_params* params, lico_callback callback, void* user);
+LICO_API LICO_Job* lico_submit_decompress(LICO_Executor* executor, const void* src, int srcsize, void* dst, int dstcap, lico_callback callback, void* user);
+
+// return whether a job has completed without blocking
+LICO_API int lico_job_done(LICO_Job* job);
+
+// block until a job has completed, release it, and return its result
+LICO_API int lico_job_wait(LICO_Job* job);
+
+// short description of an error code
+LICO_API const char* lico_error_name(int code);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
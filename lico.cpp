@@ -0,0 +1,1882 @@
+/*
+This file is part of LICO, a fast lossless image compressor.
+
+Copyright (c) 2023, Noushin Azami and Martin Burtscher
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+URL: The latest version of this code is available at https://github.com/burtscher/LICO.
+
+Publication: This work is described in detail in the following paper.
+Noushin Azami, Rain Lawson, and Martin Burtscher. "LICO: An Effective, High-Speed, Lossless Compressor for Images." Proceedings of the 2024 Data Compression Conference. Snowbird, UT. March 2024.
+
+Sponsor: This code is based upon work supported by the U.S. Department of Energy, Office of Science, Office of Advanced Scientific Research (ASCR), under contract DE-SC0022223.
+*/
+
+
+#define NDEBUG
+
+using byte = unsigned char;
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "include/lico.h"
+#include "include/h_levels.h"
+#include "include/h_arena.h"
+#include "include/h_BMP_BIT.h"
+#include "include/h_FLT_BIT.h"
+#include "include/h_MSI_BIT.h"
+#include "include/h_VOL_BIT.h"
+#include "include/h_STR_BIT.h"
+#include "include/h_PNM_BIT.h"
+#include "include/h_TIF_BIT.h"
+#include "include/h_RAW_BIT.h"
+#include "include/h_target.h"
+#include "include/h_ZERE.h"
+
+
+static const int h_head = sizeof(int) + sizeof(h_config);  // original size and configuration
+
+
+// chunk-coding pipelines for chunks of up to CS bytes
+template <int CS> using h_ZE1 = h_pipeline<h_ZERE<byte, CS>>;
+template <int CS> using h_ZE2_ZE1 = h_pipeline<h_ZERE<unsigned short, CS>, h_ZERE<byte, CS>>;
+template <int CS> using h_ZE4_ZE1 = h_pipeline<h_ZERE<unsigned int, CS>, h_ZERE<byte, CS>>;
+
+
+// log2 of the chunk size selected by the parameters or -1 if the size is not supported
+static inline int h_chunk_bits(const lico_params& p)
+{
+  if (p.chunk == 0) return h_levels[p.level].csbits;
+  for (int bits = h_min_csbits; bits <= h_max_csbits; bits++) {
+    if (p.chunk == 1 << (bits - 10)) return bits;
+  }
+  return -1;
+}
+
+
+// number of cs-byte chunks that hold size bytes (rounded up in 64 bits so that sizes near INT_MAX do not overflow)
+static inline int h_chunk_count(const long long size, const int cs)
+{
+  return (size + cs - 1) / cs;
+}
+
+
+// size of coded chunk chunkID in the size table (a 64 kB chunk stored as is wraps to 0)
+static inline int h_coded_size(const unsigned short* const size_in, const int chunkID, const int osize)
+{
+  const int csize = size_in[chunkID];
+  return ((csize == 0) && (osize > 0xffff)) ? osize : csize;
+}
+
+
+// compression context: scratch space that is reused by all calls made with the context
+struct LICO_CCtx
+{
+  h_arena data;  // transformed input
+  h_arena temp;  // pixel transform
+  h_arena image;  // pixels gathered from the strips or tiles of a file or from interleaved bands
+  h_arena offsets;  // chunk offsets
+  h_arena out;  // encoded data that may not fit the destination
+};
+
+
+// decompression context: scratch space that is reused by all calls made with the context
+struct LICO_DCtx
+{
+  h_arena data;  // decoded chunks
+  h_arena temp;  // inverse pixel transform
+  h_arena image;  // pixels gathered from the strips or tiles of a file or from interleaved bands
+  h_arena offsets;  // chunk offsets
+  h_arena slab;  // restored slab of a volume
+  h_arena out;  // restored data of the inverse transforms that do not work in place
+};
+
+
+// run a chunk-coding pipeline on the csize bytes in buf (clobbers buf and tmp) and return the buffer holding the result or nullptr if the chunk does not compress
+template <int CS>
+static inline byte* h_encode_pipe(const byte pipe, int& csize, byte buf [CS], byte tmp [CS])
+{
+  switch (pipe) {
+    case h_PIPE_ZE1: return h_ZE1<CS>::encode(csize, buf, tmp);
+    case h_PIPE_ZE2_ZE1: return h_ZE2_ZE1<CS>::encode(csize, buf, tmp);
+    default: return h_ZE4_ZE1<CS>::encode(csize, buf, tmp);
+  }
+}
+
+
+// encode chunk chunkID of the input with CS-byte chunks into output (whose header has room for chunks sizes) once the preceding chunk has been placed
+// (carry receives the end offset of each chunk)
+template <int CS>
+static inline void h_encode_kernel(const byte* const __restrict__ input, const int insize, const h_config cfg, const int chunks, const int chunkID, byte* const __restrict__ output, int* const carry)
+{
+  const int cs = CS;  // chunk size
+  unsigned short* const size_out = (unsigned short*)&output[h_head];
+  byte* const data_out = (byte*)&size_out[chunks];
+
+  // load chunk
+  long long chunk1 [CS / sizeof(long long)];
+  long long chunk2 [CS / sizeof(long long)];
+  long long chunk3 [CS / sizeof(long long)];
+  byte* const buf = (byte*)chunk1;
+  byte* const tmp = (byte*)chunk2;
+  const int base = chunkID * cs;
+  const int osize = std::min(cs, insize - base);
+
+  // encode chunk
+  int csize = osize;
+  byte* out = nullptr;
+  if (cfg.pipe != h_PIPE_SPEC) {
+    memcpy(buf, &input[base], osize);
+    out = h_encode_pipe<CS>(cfg.pipe, csize, buf, tmp);
+  } else {
+    // speculatively try every pipeline and keep the smallest result tagged with its pipeline
+    byte* const best = (byte*)chunk3;
+    for (const byte pipe: h_spec_pipes) {
+      int asize = osize;
+      memcpy(buf, &input[base], osize);
+      const byte* const res = h_encode_pipe<CS>(pipe, asize, buf, tmp);
+      if ((res != nullptr) && (asize + 1 < csize)) {
+        memcpy(best, res, asize);
+        best[asize] = pipe;
+        csize = asize + 1;
+        out = best;
+      }
+    }
+  }
+  const bool good = (out != nullptr);
+
+  int offs = 0;
+  if (chunkID > 0) {
+    do {
+      #pragma omp atomic read
+      offs = carry[chunkID - 1];
+    } while (offs == 0);
+    #pragma omp flush
+  }
+  if (good && (csize < osize)) {
+    // store compressed data
+    #pragma omp atomic write
+    carry[chunkID] = offs + csize;
+    size_out[chunkID] = csize;
+    memcpy(&data_out[offs], out, csize);
+  } else {
+    // store original data (the size of a full 64 kB chunk wraps to 0)
+    #pragma omp atomic write
+    carry[chunkID] = offs + osize;
+    size_out[chunkID] = (unsigned short)osize;
+    memcpy(&data_out[offs], &input[base], osize);
+  }
+}
+
+
+// encode a chunk with the kernel compiled for the chunk size of the configuration
+static inline void h_encode_chunk(const byte* const __restrict__ input, const int insize, const h_config cfg, const int chunks, const int chunkID, byte* const __restrict__ output, int* const carry)
+{
+  switch (cfg.csbits) {
+    case 12: h_encode_kernel<1 << 12>(input, insize, cfg, chunks, chunkID, output, carry); break;
+    case 13: h_encode_kernel<1 << 13>(input, insize, cfg, chunks, chunkID, output, carry); break;
+    case 14: h_encode_kernel<1 << 14>(input, insize, cfg, chunks, chunkID, output, carry); break;
+    case 15: h_encode_kernel<1 << 15>(input, insize, cfg, chunks, chunkID, output, carry); break;
+    default: h_encode_kernel<1 << 16>(input, insize, cfg, chunks, chunkID, output, carry); break;
+  }
+}
+
+
+// write the header of the encoded data and return its size once all chunks have been placed
+static inline int h_encode_finish(const int insize, const h_config cfg, const int chunks, byte* const output, const int* const carry)
+{
+  memcpy(output, &insize, sizeof(int));
+  memcpy(&output[sizeof(int)], &cfg, sizeof(h_config));
+  return h_head + chunks * sizeof(short) + carry[chunks - 1];
+}
+
+
+static void h_encode(const byte* const __restrict__ input, const int insize, byte* const __restrict__ output, int& outsize, const h_config cfg, h_arena& offsets)
+{
+  // initialize
+  const int cs = 1 << cfg.csbits;  // chunk size
+  const int chunks = h_chunk_count(insize, cs);
+  int* const carry = offsets.get<int>(chunks * sizeof(int));
+  memset(carry, 0, chunks * sizeof(int));
+
+  // process chunks in parallel
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int chunkID = 0; chunkID < chunks; chunkID++) {
+    h_encode_chunk(input, insize, cfg, chunks, chunkID, output, carry);
+  }
+
+  // finish
+  outsize = h_encode_finish(insize, cfg, chunks, output, carry);
+}
+
+
+// undo a chunk-coding pipeline on the csize bytes in buf (clobbers buf and tmp) and return the buffer holding the result or nullptr if the chunk is corrupt
+template <int CS>
+static inline byte* h_decode_pipe(const byte pipe, int& csize, byte buf [CS], byte tmp [CS])
+{
+  switch (pipe) {
+    case h_PIPE_ZE1: return h_ZE1<CS>::decode(csize, buf, tmp);
+    case h_PIPE_ZE2_ZE1: return h_ZE2_ZE1<CS>::decode(csize, buf, tmp);
+    default: return h_ZE4_ZE1<CS>::decode(csize, buf, tmp);
+  }
+}
+
+
+// read and check the header of the compressed data, including that the coded chunks fit into the input so that a corrupt header cannot make
+// the caller allocate the claimed output before any chunk is decoded
+static bool h_frame(const byte* const input, const int insize, int& outsize, h_config& cfg)
+{
+  if ((input == nullptr) || (insize < h_head)) return false;
+  memcpy(&outsize, input, sizeof(int));
+  memcpy(&cfg, &input[sizeof(int)], sizeof(h_config));
+  if ((outsize <= 0) || (cfg.version != h_version) || (cfg.csbits < h_min_csbits) || (cfg.csbits > h_max_csbits) || (cfg.pipe > h_PIPE_ZE2_ZE1) || (cfg.mode > h_MODE_RAW)) return false;
+  const int cs = 1 << cfg.csbits;  // chunk size
+  const int chunks = h_chunk_count(outsize, cs);
+  if (chunks > (insize - h_head) / (int)sizeof(short)) return false;
+
+  // every chunk takes at least one byte
+  const unsigned short* const size_in = (const unsigned short*)&input[h_head];
+  long long pfs = h_head + chunks * (long long)sizeof(short);
+  for (int chunkID = 0; chunkID < chunks; chunkID++) {
+    const int csize = h_coded_size(size_in, chunkID, std::min(cs, outsize - chunkID * cs));
+    if (csize == 0) return false;
+    pfs += csize;
+  }
+  return (pfs <= insize);
+}
+
+
+// convert the chunk sizes of the insize bytes of compressed data into starting positions and return whether the chunks fit into the data
+static bool h_decode_starts(const byte* const input, const int insize, const int outsize, const h_config cfg, int* const start)
+{
+  const int cs = 1 << cfg.csbits;  // chunk size
+  const int chunks = h_chunk_count(outsize, cs);
+  const unsigned short* const size_in = (const unsigned short*)&input[h_head];
+  const long long avail = &input[insize] - (const byte*)&size_in[chunks];
+  long long pfs = 0;
+  for (int chunkID = 0; chunkID < chunks; chunkID++) {
+    start[chunkID] = pfs;
+    pfs += h_coded_size(size_in, chunkID, std::min(cs, outsize - chunkID * cs));
+  }
+  return (pfs <= avail);
+}
+
+
+// decode chunk chunkID of the compressed data with CS-byte chunks, whose chunks start at the given positions, into dst and return whether the chunk is intact
+template <int CS>
+static inline bool h_decode_kernel(const byte* const __restrict__ input, const int outsize, const h_config cfg, const int* const start, const int chunkID, byte* const __restrict__ dst)
+{
+  const int cs = CS;  // chunk size
+  const int chunks = h_chunk_count(outsize, cs);
+  const unsigned short* const size_in = (const unsigned short*)&input[h_head];
+  const byte* const data_in = (const byte*)&size_in[chunks];
+
+  // load chunk
+  long long chunk1 [CS / sizeof(long long)];
+  long long chunk2 [CS / sizeof(long long)];
+  byte* const buf = (byte*)chunk1;
+  byte* const tmp = (byte*)chunk2;
+  const int osize = std::min(cs, outsize - chunkID * cs);
+  int csize = h_coded_size(size_in, chunkID, osize);
+  if (csize == osize) {
+    // simply copy
+    memcpy(dst, &data_in[start[chunkID]], osize);
+    return true;
+  }
+  if ((csize == 0) || (csize > osize)) return false;
+
+  // decompress
+  memcpy(buf, &data_in[start[chunkID]], csize);
+
+  // decode
+  byte pipe = cfg.pipe;
+  if (pipe == h_PIPE_SPEC) {
+    csize--;
+    pipe = buf[csize];
+  }
+  if ((csize == 0) || (pipe == h_PIPE_SPEC) || (pipe > h_PIPE_ZE2_ZE1)) return false;
+  const byte* const out = h_decode_pipe<CS>(pipe, csize, buf, tmp);
+  if ((out == nullptr) || (csize != osize)) return false;
+  memcpy(dst, out, csize);
+  return true;
+}
+
+
+// decode a chunk with the kernel compiled for the chunk size of the configuration (which h_frame has checked)
+static inline bool h_decode_chunk(const byte* const __restrict__ input, const int outsize, const h_config cfg, const int* const start, const int chunkID, byte* const __restrict__ dst)
+{
+  switch (cfg.csbits) {
+    case 12: return h_decode_kernel<1 << 12>(input, outsize, cfg, start, chunkID, dst);
+    case 13: return h_decode_kernel<1 << 13>(input, outsize, cfg, start, chunkID, dst);
+    case 14: return h_decode_kernel<1 << 14>(input, outsize, cfg, start, chunkID, dst);
+    case 15: return h_decode_kernel<1 << 15>(input, outsize, cfg, start, chunkID, dst);
+    default: return h_decode_kernel<1 << 16>(input, outsize, cfg, start, chunkID, dst);
+  }
+}
+
+
+// decode chunks c0 to c1 - 1 of the insize bytes of compressed data into output (chunk c0 is written to output[0]) and return whether the data is intact
+static bool h_decode_chunks(const byte* const __restrict__ input, const int insize, const int c0, const int c1, byte* const __restrict__ output, h_arena& offsets)
+{
+  // input header
+  int outsize;
+  h_config cfg;
+  if (!h_frame(input, insize, outsize, cfg)) return false;
+
+  // initialize
+  const int cs = 1 << cfg.csbits;  // chunk size
+  const int chunks = h_chunk_count(outsize, cs);
+  if ((c0 < 0) || (c0 >= c1) || (c1 > chunks)) return false;
+  int* const start = offsets.get<int>(chunks * sizeof(int));
+  bool ok = h_decode_starts(input, insize, outsize, cfg, start);
+
+  // process chunks in parallel
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int chunkID = c0; chunkID < c1; chunkID++) {
+    bool good;
+    #pragma omp atomic read
+    good = ok;
+    if (good && !h_decode_chunk(input, outsize, cfg, start, chunkID, &output[(chunkID - c0) * cs])) {
+      #pragma omp atomic write
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+
+// decode slices z0 to z1 - 1 of a compressed volume into output by decoding just the chunks of the slabs that contain them and return the decoded size or an error code
+static int h_decode_slices(LICO_DCtx& ctx, const byte* const __restrict__ input, const int insize, const int z0, const int z1, byte* const __restrict__ output, const int outcap)
+{
+  // input header
+  int vsize;
+  h_config cfg;
+  if (!h_frame(input, insize, vsize, cfg)) return LICO_ERROR_CORRUPT;
+  if (cfg.mode != h_MODE_VOL) return LICO_ERROR_MODE;
+  const int cs = 1 << cfg.csbits;  // chunk size
+
+  // read side information from the first chunk
+  byte* const first = ctx.data.get(cs);
+  h_VOL_BIT_info vi;
+  const bool valid = h_decode_chunks(input, insize, 0, 1, first, ctx.offsets) && h_VOL_BIT_read(first, std::min(cs, vsize), vi) && (h_BMP_BIT_extent(vi.w, vi.h, vi.d, vi.bytes) + h_VOL_BIT_side == vsize);
+  if (!valid) return LICO_ERROR_CORRUPT;
+  if ((z0 < 0) || (z0 >= z1) || (z1 > vi.d)) return LICO_ERROR_ARGUMENT;
+  const int ss = vi.w * vi.h * vi.bytes;  // slice size
+  if ((long long)(z1 - z0) * ss > outcap) return LICO_ERROR_CAPACITY;
+
+  // decode the chunks that overlap the slabs containing the slices
+  const int k0 = z0 / vi.slab;
+  const int k1 = (z1 - 1) / vi.slab + 1;
+  const int beg = h_VOL_BIT_offset(vi, k0);
+  const int end = h_VOL_BIT_offset(vi, k1);
+  const int c0 = beg / cs;
+  const int c1 = h_chunk_count(end, cs);
+  byte* const data = ctx.data.get((long long)(c1 - c0) * cs);
+  if (!h_decode_chunks(input, insize, c0, c1, data, ctx.offsets)) return LICO_ERROR_CORRUPT;
+
+  // restore the slabs (one per thread, each into its own part of the scratch buffers) and copy the requested slices
+  const long long room = (long long)vi.slab * ss;  // bytes of a slab
+  byte* const slab = ctx.slab.get((k1 - k0) * room);
+  byte* const tmp = ctx.temp.get((k1 - k0) * room);
+  #pragma omp parallel for default(none) shared(vi, k0, k1, c0, cs, z0, z1, ss, room, data, slab, tmp, output, cfg) schedule(dynamic, 1) if (k1 - k0 > 1)
+  for (int k = k0; k < k1; k++) {
+    const int off = h_VOL_BIT_offset(vi, k);
+    byte* const res = &slab[(k - k0) * room];
+    h_iVOL_BIT_slab(&data[off - c0 * cs], vi, k, cfg.pred, res, &tmp[(k - k0) * room]);
+    const int s0 = std::max(z0, k * vi.slab);
+    const int s1 = std::min(z1, (k + 1) * vi.slab);
+    memcpy(&output[(s0 - z0) * ss], &res[(s0 - k * vi.slab) * ss], (s1 - s0) * ss);
+  }
+  return (z1 - z0) * ss;
+}
+
+
+// whether the parameters fit srcsize bytes of input (pixel buffers must hold exactly width x height pixels of their format)
+static inline bool h_params_fit(const lico_params& p, const int srcsize)
+{
+  if (p.mode != LICO_MODE_RAW) return true;
+  const int ps = h_RAW_BIT_pixel(p.format);
+  return (p.width > 0) && (p.height > 0) && (ps > 0) && (h_BMP_BIT_extent(p.width, p.height, ps) == srcsize);
+}
+
+
+// apply the transform of the requested mode to the input and return the transformed data, which is the input itself if no transform applies
+// and otherwise lives in the context
+static const byte* h_transform(LICO_CCtx& ctx, const byte* const input, const int insize, const lico_params& p, h_config& cfg, int& size)
+{
+  bool transformed = false;
+  byte* data = nullptr;
+  size = insize;
+  const bool bmp = (insize >= 2) && (input[0] == 'B') && (input[1] == 'M');
+  const bool pnm = (insize >= 2) && (input[0] == 'P') && (input[1] >= '5') && (input[1] <= '7');
+  const bool tif = (insize >= 4) && (((input[0] == 'I') && (input[1] == 'I')) || ((input[0] == 'M') && (input[1] == 'M')));
+  if (p.mode == LICO_MODE_RAW) {
+    // read the pixels straight from the input
+    cfg.mode = h_MODE_RAW;
+    const int ps = h_RAW_BIT_pixel(p.format);
+    if ((size = h_RAW_BIT_size(p.width, p.height, p.width * ps, p.format)) > 0) {
+      data = ctx.data.get(size);
+      transformed = h_RAW_BIT(input, p.width, p.height, p.width * ps, p.format, cfg.pred, data, ctx.temp);
+    }
+  } else if (p.mode == LICO_MODE_STR) {
+    // read the records straight from the input
+    cfg.mode = h_MODE_STR;
+    data = ctx.data.get((long long)insize + h_STR_BIT_side);
+    transformed = h_STR_BIT(size, input, data, p.stride, (p.element == 0) ? 1 : p.element, cfg.pred, ctx.temp);
+  } else if (p.mode == LICO_MODE_AUTO) {
+    if (bmp) {
+      // BMP images are transformed in place
+      data = ctx.data.get(insize);
+      memcpy(data, input, insize);
+      transformed = h_BMP_BIT(size, data, cfg.pred, ctx.temp);
+    } else if (pnm || tif) {
+      cfg.mode = pnm ? h_MODE_PNM : h_MODE_TIF;
+      data = ctx.data.get((long long)insize + h_TIF_BIT_side);
+      transformed = pnm ? h_PNM_BIT(size, input, data, cfg.pred, ctx.temp) : h_TIF_BIT(size, input, data, cfg.pred, ctx.image, ctx.temp);
+    }
+    int stride, width;
+    if (!transformed && (cfg.pred != h_PRED_NONE) && h_STR_BIT_detect(input, insize, stride, width)) {
+      // not a supported image but made of records (detected on the input so that other data is not copied)
+      cfg.mode = h_MODE_STR;
+      size = insize;
+      data = ctx.data.get((long long)insize + h_STR_BIT_side);
+      transformed = h_STR_BIT(size, input, data, stride, width, cfg.pred, ctx.temp);
+    }
+  } else {
+    // read the samples straight from the input (the side information of multispectral images is the largest)
+    const int bytes = (p.bytes == 0) ? 1 : p.bytes;
+    data = ctx.data.get((long long)insize + h_MSI_BIT_side);
+    if (p.mode == LICO_MODE_F32) {
+      cfg.mode = h_MODE_F32;
+      transformed = h_FLT_BIT(size, input, data, p.width, p.height, cfg.pred, ctx.temp);
+    } else if (p.mode == LICO_MODE_MSI) {
+      cfg.mode = h_MODE_MSI;
+      transformed = h_MSI_BIT(size, input, data, p.width, p.height, p.depth, bytes, p.planar ? h_MSI_BIT_BSQ : h_MSI_BIT_BIP, p.ref, cfg.pred, ctx.image, ctx.temp);
+    } else {
+      cfg.mode = h_MODE_VOL;
+      transformed = h_VOL_BIT(size, input, data, p.width, p.height, p.depth, bytes, (p.slab == 0) ? h_VOL_BIT_slab : p.slab, cfg.pred, ctx.temp);
+    }
+  }
+  if (!transformed) {
+    // store the input as is
+    size = insize;
+    cfg.pred = h_PRED_NONE;
+    cfg.mode = h_MODE_BMP;
+    return input;
+  }
+  return data;
+}
+
+
+// encode the transformed data into dst and return the compressed size or an error code
+static int h_compress(LICO_CCtx& ctx, const byte* const data, const int size, const h_config cfg, byte* const dst, const int dstcap)
+{
+  // every chunk that does not compress is stored as is
+  const int cs = 1 << cfg.csbits;  // chunk size
+  const int chunks = h_chunk_count(size, cs);
+  const long long maxsize = h_head + chunks * sizeof(short) + (long long)size;
+  if (maxsize > 0x7fffffff) return LICO_ERROR_ARGUMENT;
+  int outsize = 0;
+  if (maxsize <= dstcap) {
+    h_encode(data, size, dst, outsize, cfg, ctx.offsets);
+  } else {
+    byte* const tmp = ctx.out.get(maxsize);
+    h_encode(data, size, tmp, outsize, cfg, ctx.offsets);
+    if (outsize > dstcap) return LICO_ERROR_CAPACITY;
+    memcpy(dst, tmp, outsize);
+  }
+  return outsize;
+}
+
+
+// return the buffer that the size bytes of decoded data go to (dst for BMP data, which the inverse transform restores in place, and the context
+// for the remaining modes, whose inverse transforms restore the data in place or into another buffer of the context) or null if dst is too small
+static byte* h_target(LICO_DCtx& ctx, const h_config cfg, const int size, byte* const dst, const int dstcap)
+{
+  if (cfg.mode == h_MODE_BMP) return (size <= dstcap) ? dst : nullptr;
+  return ctx.data.get(size);
+}
+
+
+// undo the transform on the size bytes of decoded data in the buffer returned by h_target and return the decompressed size or an error code
+static int h_restore(LICO_DCtx& ctx, const bool decoded, const h_config cfg, int size, byte* data, byte* const dst, const int dstcap)
+{
+  if (cfg.mode == h_MODE_BMP) {
+    if (!decoded || ((cfg.pred != h_PRED_NONE) && !h_iBMP_BIT(size, data, cfg.pred, ctx.temp))) return LICO_ERROR_CORRUPT;
+    return size;
+  }
+
+  if (cfg.mode == h_MODE_RAW) {
+    // write the pixels straight into a packed buffer
+    int w, h, fmt;
+    if (!decoded || !h_RAW_BIT_info(data, size, w, h, fmt)) return LICO_ERROR_CORRUPT;
+    const int bytes = w * h_RAW_BIT_pixel(fmt);
+    if ((long long)bytes * h > dstcap) return LICO_ERROR_CAPACITY;
+    return h_iRAW_BIT(data, size, cfg.pred, dst, bytes, ctx.temp) ? (bytes * h) : LICO_ERROR_CORRUPT;
+  }
+
+  bool restored = decoded;
+  if (restored) {
+    switch (cfg.mode) {
+      case h_MODE_F32: restored = h_iFLT_BIT(size, data, cfg.pred, ctx.temp); break;
+      case h_MODE_MSI: restored = h_iMSI_BIT(size, data, cfg.pred, ctx.out, ctx.image, ctx.temp); break;
+      case h_MODE_VOL: restored = h_iVOL_BIT(size, data, cfg.pred, ctx.out, ctx.temp); break;
+      case h_MODE_STR: restored = h_iSTR_BIT(size, data, cfg.pred, ctx.out, ctx.temp); break;
+      case h_MODE_PNM: restored = h_iPNM_BIT(size, data, cfg.pred, ctx.temp); break;
+      default: restored = h_iTIF_BIT(size, data, cfg.pred, ctx.image, ctx.temp); break;
+    }
+  }
+  if (!restored) return LICO_ERROR_CORRUPT;
+  if (size > dstcap) return LICO_ERROR_CAPACITY;
+  memcpy(dst, data, size);
+  return size;
+}
+
+
+// decode the chunks of compressed image data into the context and describe its pixels without restoring the image, returning 0 or an error code
+static int h_open_image(LICO_DCtx& ctx, const byte* const input, const int srcsize, h_config& cfg, h_image& img)
+{
+  int size;
+  if (!h_frame(input, srcsize, size, cfg)) return LICO_ERROR_CORRUPT;
+  if ((cfg.mode != h_MODE_BMP) && (cfg.mode != h_MODE_PNM) && (cfg.mode != h_MODE_RAW)) return LICO_ERROR_MODE;
+  byte* const data = ctx.data.get(size);
+  if (!h_decode_chunks(input, srcsize, 0, h_chunk_count(size, 1 << cfg.csbits), data, ctx.offsets)) return LICO_ERROR_CORRUPT;
+
+  // data stored as is may be any file, and BMP mode also covers layouts without a pixel view (e.g., 1 bpp)
+  const bool transformed = (cfg.pred != h_PRED_NONE);
+  switch (cfg.mode) {
+    case h_MODE_BMP:
+      if (transformed) return h_BMP_BIT_image(data, size, true, img) ? 0 : LICO_ERROR_MODE;
+      return (h_BMP_BIT_image(data, size, false, img) || h_PNM_BIT_image(data, size, false, img)) ? 0 : LICO_ERROR_MODE;
+    case h_MODE_PNM: return h_PNM_BIT_image(data, size, true, img) ? 0 : LICO_ERROR_CORRUPT;
+    default: return h_RAW_BIT_image(data, size, transformed, img) ? 0 : LICO_ERROR_CORRUPT;
+  }
+}
+
+
+LICO_CCtx* lico_create_cctx(void)
+{
+  return new (std::nothrow) LICO_CCtx;
+}
+
+
+void lico_free_cctx(LICO_CCtx* const cctx)
+{
+  delete cctx;
+}
+
+
+LICO_DCtx* lico_create_dctx(void)
+{
+  return new (std::nothrow) LICO_DCtx;
+}
+
+
+void lico_free_dctx(LICO_DCtx* const dctx)
+{
+  delete dctx;
+}
+
+
+int lico_compress(const void* const src, const int srcsize, void* const dst, const int dstcap, const int level)
+{
+  lico_params p;
+  memset(&p, 0, sizeof(p));
+  p.level = level;
+  LICO_CCtx ctx;
+  return lico_compress_cctx(&ctx, src, srcsize, dst, dstcap, &p);
+}
+
+
+int lico_compress_params(const void* const src, const int srcsize, void* const dst, const int dstcap, const lico_params* const params)
+{
+  LICO_CCtx ctx;
+  return lico_compress_cctx(&ctx, src, srcsize, dst, dstcap, params);
+}
+
+
+int lico_compress_cctx(LICO_CCtx* const cctx, const void* const src, const int srcsize, void* const dst, const int dstcap, const lico_params* const params)
+try {
+  lico_params p;
+  memset(&p, 0, sizeof(p));
+  if (params != nullptr) p = *params;
+  if (p.level == 0) p.level = h_default_level;
+  if ((cctx == nullptr) || (src == nullptr) || (srcsize < 1) || (dst == nullptr) || (dstcap < 0) || (p.level < h_min_level) || (p.level > h_max_level) || (p.mode < LICO_MODE_AUTO) || (p.mode > LICO_MODE_RAW) || (h_chunk_bits(p) < 0) || !h_params_fit(p, srcsize)) return LICO_ERROR_ARGUMENT;
+
+  h_config cfg = h_levels[p.level];
+  cfg.csbits = h_chunk_bits(p);
+  int size = 0;
+  const byte* const data = h_transform(*cctx, (const byte*)src, srcsize, p, cfg, size);
+  return h_compress(*cctx, data, size, cfg, (byte*)dst, dstcap);
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_compress_pixels(const void* const pix, const int width, const int height, const int stride, const int format, void* const dst, const int dstcap, const int level)
+{
+  LICO_CCtx ctx;
+  return lico_compress_pixels_cctx(&ctx, pix, width, height, stride, format, dst, dstcap, level);
+}
+
+
+int lico_compress_pixels_cctx(LICO_CCtx* const cctx, const void* const pix, const int width, const int height, const int stride, const int format, void* const dst, const int dstcap, const int level)
+try {
+  const int lev = (level == 0) ? h_default_level : level;
+  if ((cctx == nullptr) || (pix == nullptr) || (dst == nullptr) || (dstcap < 0) || (lev < h_min_level) || (lev > h_max_level)) return LICO_ERROR_ARGUMENT;
+
+  h_config cfg = h_levels[lev];
+  cfg.mode = h_MODE_RAW;
+  const int size = h_RAW_BIT_size(width, height, stride, format);
+  if (size == 0) return LICO_ERROR_ARGUMENT;
+  byte* const data = cctx->data.get(size);
+  h_RAW_BIT((const byte*)pix, width, height, stride, format, cfg.pred, data, cctx->temp);
+  return h_compress(*cctx, data, size, cfg, (byte*)dst, dstcap);
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_compress_bound(const int size, const lico_params* const params)
+{
+  lico_params p;
+  memset(&p, 0, sizeof(p));
+  if (params != nullptr) p = *params;
+  if (p.level == 0) p.level = h_default_level;
+  if ((size < 1) || (p.level < h_min_level) || (p.level > h_max_level) || (p.mode < LICO_MODE_AUTO) || (p.mode > LICO_MODE_RAW) || (h_chunk_bits(p) < 0) || !h_params_fit(p, size)) return LICO_ERROR_ARGUMENT;
+
+  // largest transformed size
+  long long tsize;
+  switch (p.mode) {
+    case LICO_MODE_F32: tsize = size + h_FLT_BIT_side; break;
+    case LICO_MODE_MSI: tsize = size + h_MSI_BIT_side; break;
+    case LICO_MODE_VOL: tsize = size + h_VOL_BIT_side; break;
+    case LICO_MODE_STR: tsize = size + h_STR_BIT_side; break;
+    case LICO_MODE_RAW: tsize = size + h_RAW_BIT_side; break;
+    default: tsize = (long long)size + h_TIF_BIT_side; break;  // the side information of TIFF files is the largest growth of the detected formats
+  }
+
+  // every chunk may be stored as is
+  const int cs = 1 << h_chunk_bits(p);  // chunk size
+  const long long bound = h_head + (tsize + cs - 1) / cs * sizeof(short) + tsize;
+  return (bound > 0x7fffffff) ? LICO_ERROR_ARGUMENT : bound;
+}
+
+
+int lico_get_frame_info(const void* const src, const int srcsize, lico_frame_info* const info)
+try {
+  if ((src == nullptr) || (info == nullptr)) return LICO_ERROR_ARGUMENT;
+  const byte* const input = (const byte*)src;
+  int tsize;
+  h_config cfg;
+  if (!h_frame(input, srcsize, tsize, cfg)) return LICO_ERROR_CORRUPT;
+  const int cs = 1 << cfg.csbits;  // chunk size
+  memset(info, 0, sizeof(lico_frame_info));
+  info->size = tsize;
+  info->level = cfg.level;
+  info->chunks = h_chunk_count(tsize, cs);
+  info->bytes = 1;
+  info->format = -1;
+
+  // the modes keep their geometry in side information or an image header at the start of the transformed data
+  long long chunk [(1 << h_max_csbits) / sizeof(long long)];
+  byte* const first = (byte*)chunk;
+  h_arena offsets;
+  if (!h_decode_chunks(input, srcsize, 0, 1, first, offsets)) return LICO_ERROR_CORRUPT;
+  const int fsize = std::min(cs, tsize);
+  bool valid = false;
+  if ((cfg.mode == h_MODE_BMP) && (cfg.pred == h_PRED_NONE)) {
+    // data stored as is reports the geometry of BMP and Netpbm images
+    info->mode = LICO_MODE_STORE;
+    int w, h, C, maxval, off;
+    if ((fsize >= 54) && (first[0] == 'B') && (first[1] == 'M')) {
+      const int sh = h_BMP_BIT_get4(&first[22]);
+      const int bpp = h_BMP_BIT_get2(&first[28]);
+      info->width = h_BMP_BIT_get4(&first[18]);
+      info->height = (sh < 0) ? -sh : sh;
+      info->bytes = (bpp == 48) ? 2 : 1;
+      info->channels = (bpp == 32) ? 4 : ((bpp >= 24) ? 3 : 1);
+    } else if ((fsize >= 2) && (first[0] == 'P') && h_PNM_BIT_fields(first, fsize, w, h, C, maxval, off)) {
+      info->width = w;
+      info->height = h;
+      info->bytes = (maxval < 256) ? 1 : 2;
+      info->channels = C;
+    }
+    valid = true;
+  } else if (cfg.mode == h_MODE_BMP) {
+    info->mode = LICO_MODE_BMP;
+    if (fsize >= 54) {
+      const int sh = h_BMP_BIT_get4(&first[22]);
+      info->width = h_BMP_BIT_get4(&first[18]);
+      info->height = (sh < 0) ? -sh : sh;
+      const int bpp = (h_BMP_BIT_get2(&first[28]) + 24) & 0xffff;
+      info->bytes = (bpp == 48) ? 2 : 1;
+      info->channels = (bpp == 32) ? 4 : ((bpp >= 24) ? 3 : 1);
+      valid = true;
+    }
+  } else if (cfg.mode == h_MODE_F32) {
+    info->mode = LICO_MODE_F32;
+    if (fsize >= h_FLT_BIT_side) {
+      info->width = h_BMP_BIT_get4(&first[0]);
+      info->height = h_BMP_BIT_get4(&first[4]);
+      info->bytes = sizeof(float);
+      info->size = tsize - h_FLT_BIT_side;
+      valid = true;
+    }
+  } else if (cfg.mode == h_MODE_MSI) {
+    info->mode = LICO_MODE_MSI;
+    if (fsize >= h_MSI_BIT_side) {
+      info->width = h_BMP_BIT_get4(&first[0]);
+      info->height = h_BMP_BIT_get4(&first[4]);
+      info->depth = h_BMP_BIT_get4(&first[8]);
+      info->bytes = h_BMP_BIT_get4(&first[12]);
+      info->size = tsize - h_MSI_BIT_side;
+      valid = true;
+    }
+  } else if (cfg.mode == h_MODE_VOL) {
+    info->mode = LICO_MODE_VOL;
+    h_VOL_BIT_info vi;
+    if (h_VOL_BIT_read(first, fsize, vi)) {
+      info->width = vi.w;
+      info->height = vi.h;
+      info->depth = vi.d;
+      info->bytes = vi.bytes;
+      info->size = tsize - h_VOL_BIT_side;
+      valid = true;
+    }
+  } else if (cfg.mode == h_MODE_STR) {
+    info->mode = LICO_MODE_STR;
+    if (fsize >= h_STR_BIT_side) {
+      info->width = h_BMP_BIT_get4(&first[0]);
+      info->bytes = h_BMP_BIT_get4(&first[4]);
+      info->size = tsize - h_STR_BIT_side;
+      info->height = (info->width > 0) ? (info->size / info->width) : 0;
+      valid = true;
+    }
+  } else if (cfg.mode == h_MODE_PNM) {
+    info->mode = LICO_MODE_PNM;
+    const int base = first[0] / 16;
+    int C, maxval, off;
+    if ((base <= 1) && h_PNM_BIT_fields(&first[base], fsize - base, info->width, info->height, C, maxval, off)) {
+      info->bytes = (maxval < 256) ? 1 : 2;
+      info->channels = C;
+      info->size = tsize - base;
+      valid = true;
+    }
+  } else if (cfg.mode == h_MODE_TIF) {
+    info->mode = LICO_MODE_TIF;
+    if (fsize >= h_TIF_BIT_side) {
+      info->size = h_BMP_BIT_get4(&first[0]);
+      info->width = h_BMP_BIT_get4(&first[8]);
+      info->height = h_BMP_BIT_get4(&first[12]);
+      valid = true;
+    }
+  } else {
+    info->mode = LICO_MODE_RAW;
+    if (fsize >= h_RAW_BIT_side) {
+      info->width = h_BMP_BIT_get4(&first[0]);
+      info->height = h_BMP_BIT_get4(&first[4]);
+      info->format = h_BMP_BIT_get4(&first[8]);
+      const int ps = h_RAW_BIT_pixel(info->format);
+      if ((ps > 0) && (info->width > 0) && (info->height > 0) && ((long long)info->width * info->height * ps + h_RAW_BIT_side == tsize)) {
+        info->bytes = h_RAW_bytes[info->format];
+        info->channels = h_RAW_channels[info->format];
+        info->size = tsize - h_RAW_BIT_side;
+        valid = true;
+      }
+    }
+  }
+  return (valid && (info->size > 0) && (info->size <= tsize)) ? 0 : LICO_ERROR_CORRUPT;
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_decompress(const void* const src, const int srcsize, void* const dst, const int dstcap)
+{
+  LICO_DCtx ctx;
+  return lico_decompress_dctx(&ctx, src, srcsize, dst, dstcap);
+}
+
+
+int lico_decompress_dctx(LICO_DCtx* const dctx, const void* const src, const int srcsize, void* const dst, const int dstcap)
+try {
+  if ((dctx == nullptr) || (src == nullptr) || (dst == nullptr) || (dstcap < 0)) return LICO_ERROR_ARGUMENT;
+  const byte* const input = (const byte*)src;
+  int size;
+  h_config cfg;
+  if (!h_frame(input, srcsize, size, cfg)) return LICO_ERROR_CORRUPT;
+  const int chunks = h_chunk_count(size, 1 << cfg.csbits);
+
+  // decode the chunks where the inverse transform expects them
+  byte* const data = h_target(*dctx, cfg, size, (byte*)dst, dstcap);
+  if (data == nullptr) return LICO_ERROR_CAPACITY;
+  const bool decoded = h_decode_chunks(input, srcsize, 0, chunks, data, dctx->offsets);
+  return h_restore(*dctx, decoded, cfg, size, data, (byte*)dst, dstcap);
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_decompress_pixels(const void* const src, const int srcsize, void* const pix, const int stride)
+{
+  LICO_DCtx ctx;
+  return lico_decompress_pixels_dctx(&ctx, src, srcsize, pix, stride);
+}
+
+
+int lico_decompress_pixels_dctx(LICO_DCtx* const dctx, const void* const src, const int srcsize, void* const pix, const int stride)
+try {
+  if ((dctx == nullptr) || (src == nullptr) || (pix == nullptr)) return LICO_ERROR_ARGUMENT;
+  const byte* const input = (const byte*)src;
+  int size;
+  h_config cfg;
+  if (!h_frame(input, srcsize, size, cfg)) return LICO_ERROR_CORRUPT;
+  if (cfg.mode != h_MODE_RAW) return LICO_ERROR_MODE;
+
+  byte* const data = dctx->data.get(size);
+  int w, h, fmt;
+  if (!h_decode_chunks(input, srcsize, 0, h_chunk_count(size, 1 << cfg.csbits), data, dctx->offsets) || !h_RAW_BIT_info(data, size, w, h, fmt)) return LICO_ERROR_CORRUPT;
+  const int bytes = w * h_RAW_BIT_pixel(fmt);
+  if (bytes > (stride < 0 ? -(long long)stride : stride)) return LICO_ERROR_ARGUMENT;
+  return h_iRAW_BIT(data, size, cfg.pred, (byte*)pix, stride, dctx->temp) ? (bytes * h) : LICO_ERROR_CORRUPT;
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_decompress_slices(const void* const src, const int srcsize, const int first, const int last, void* const dst, const int dstcap)
+{
+  LICO_DCtx ctx;
+  return lico_decompress_slices_dctx(&ctx, src, srcsize, first, last, dst, dstcap);
+}
+
+
+int lico_decompress_slices_dctx(LICO_DCtx* const dctx, const void* const src, const int srcsize, const int first, const int last, void* const dst, const int dstcap)
+try {
+  if ((dctx == nullptr) || (src == nullptr) || (dst == nullptr) || (dstcap < 0)) return LICO_ERROR_ARGUMENT;
+  return h_decode_slices(*dctx, (const byte*)src, srcsize, first, last, (byte*)dst, dstcap);
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_compress_batch(lico_batch_item* const items, const int count)
+try {
+  if ((items == nullptr) || (count < 1)) return LICO_ERROR_ARGUMENT;
+
+  // transform the items concurrently (every item has its own context that holds its transformed data and output)
+  std::vector<LICO_CCtx> ctx(count);
+  std::vector<h_config> cfg(count);
+  std::vector<int> size(count, 0);
+  std::vector<const byte*> data(count, nullptr);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < count; i++) {
+    lico_batch_item& item = items[i];
+    lico_params p;
+    memset(&p, 0, sizeof(p));
+    if (item.params != nullptr) p = *item.params;
+    if (p.level == 0) p.level = h_default_level;
+    if ((item.src == nullptr) || (item.srcsize < 1) || (item.dst == nullptr) || (item.dstcap < 0) || (p.level < h_min_level) || (p.level > h_max_level) || (p.mode < LICO_MODE_AUTO) || (p.mode > LICO_MODE_RAW) || (h_chunk_bits(p) < 0) || !h_params_fit(p, item.srcsize)) {
+      item.result = LICO_ERROR_ARGUMENT;
+    } else {
+      cfg[i] = h_levels[p.level];
+      cfg[i].csbits = h_chunk_bits(p);
+      // an allocation failure only fails its item (exceptions must not leave the parallel region)
+      try {
+        data[i] = h_transform(ctx[i], (const byte*)item.src, item.srcsize, p, cfg[i], size[i]);
+        item.result = 0;
+      } catch (const std::bad_alloc&) {
+        item.result = LICO_ERROR_MEMORY;
+      }
+    }
+  }
+
+  // place the output of every item and number the chunks of all items consecutively
+  std::vector<byte*> out(count, nullptr);
+  std::vector<int*> carry(count, nullptr);
+  std::vector<int> first(count + 1, 0);
+  for (int i = 0; i < count; i++) {
+    int chunks = 0;
+    if (data[i] != nullptr) {
+      const int cs = 1 << cfg[i].csbits;  // chunk size
+      const int n = h_chunk_count(size[i], cs);
+      const long long maxsize = h_head + n * sizeof(short) + (long long)size[i];
+      if ((maxsize > 0x7fffffff) || ((long long)first[i] + n > 0x7fffffff)) {
+        items[i].result = LICO_ERROR_ARGUMENT;
+      } else {
+        try {
+          out[i] = (maxsize <= items[i].dstcap) ? (byte*)items[i].dst : ctx[i].out.get(maxsize);
+          carry[i] = ctx[i].offsets.get<int>(n * sizeof(int));
+          memset(carry[i], 0, n * sizeof(int));
+          chunks = n;
+        } catch (const std::bad_alloc&) {
+          out[i] = nullptr;
+          items[i].result = LICO_ERROR_MEMORY;
+        }
+      }
+    }
+    first[i + 1] = first[i] + chunks;
+  }
+
+  // process the chunks of all items in parallel from one queue (the chunks of an item are handed out in order, so the chunk whose placement
+  // a chunk waits for is always being processed)
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int g = 0; g < first[count]; g++) {
+    const int i = std::upper_bound(first.begin(), first.end(), g) - first.begin() - 1;
+    h_encode_chunk(data[i], size[i], cfg[i], first[i + 1] - first[i], g - first[i], out[i], carry[i]);
+  }
+
+  // finish the outputs
+  int result = 0;
+  for (int i = 0; i < count; i++) {
+    lico_batch_item& item = items[i];
+    if (out[i] != nullptr) {
+      const int outsize = h_encode_finish(size[i], cfg[i], first[i + 1] - first[i], out[i], carry[i]);
+      if (out[i] == item.dst) {
+        item.result = outsize;
+      } else if (outsize > item.dstcap) {
+        item.result = LICO_ERROR_CAPACITY;
+      } else {
+        memcpy(item.dst, out[i], outsize);
+        item.result = outsize;
+      }
+    }
+    if ((result == 0) && (item.result < 0)) result = item.result;
+  }
+  return result;
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_decompress_batch(lico_batch_item* const items, const int count)
+try {
+  if ((items == nullptr) || (count < 1)) return LICO_ERROR_ARGUMENT;
+
+  // read the headers and number the chunks of all items consecutively
+  std::vector<LICO_DCtx> ctx(count);
+  std::vector<h_config> cfg(count);
+  std::vector<int> size(count, 0);
+  std::vector<byte*> data(count, nullptr);
+  std::vector<int*> start(count, nullptr);
+  std::vector<int> ok(count, 0);
+  std::vector<int> first(count + 1, 0);
+  for (int i = 0; i < count; i++) {
+    lico_batch_item& item = items[i];
+    const byte* const input = (const byte*)item.src;
+    int chunks = 0;
+    item.result = 0;
+    if ((input == nullptr) || (item.dst == nullptr) || (item.dstcap < 0)) {
+      item.result = LICO_ERROR_ARGUMENT;
+    } else if (!h_frame(input, item.srcsize, size[i], cfg[i]) || ((long long)first[i] + h_chunk_count(size[i], 1 << cfg[i].csbits) > 0x7fffffff)) {
+      item.result = LICO_ERROR_CORRUPT;
+    } else {
+      try {
+        const int n = h_chunk_count(size[i], 1 << cfg[i].csbits);
+        if ((data[i] = h_target(ctx[i], cfg[i], size[i], (byte*)item.dst, item.dstcap)) == nullptr) {
+          item.result = LICO_ERROR_CAPACITY;
+        } else {
+          start[i] = ctx[i].offsets.get<int>(n * sizeof(int));
+          ok[i] = h_decode_starts(input, item.srcsize, size[i], cfg[i], start[i]);
+          chunks = n;
+        }
+      } catch (const std::bad_alloc&) {
+        data[i] = nullptr;
+        item.result = LICO_ERROR_MEMORY;
+      }
+    }
+    first[i + 1] = first[i] + chunks;
+  }
+
+  // process the chunks of all items in parallel from one queue
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int g = 0; g < first[count]; g++) {
+    const int i = std::upper_bound(first.begin(), first.end(), g) - first.begin() - 1;
+    const int chunkID = g - first[i];
+    int good;
+    #pragma omp atomic read
+    good = ok[i];
+    if (good && !h_decode_chunk((const byte*)items[i].src, size[i], cfg[i], start[i], chunkID, &data[i][chunkID << cfg[i].csbits])) {
+      #pragma omp atomic write
+      ok[i] = 0;
+    }
+  }
+
+  // undo the transforms concurrently
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < count; i++) {
+    if (data[i] != nullptr) {
+      try {
+        items[i].result = h_restore(ctx[i], ok[i] != 0, cfg[i], size[i], data[i], (byte*)items[i].dst, items[i].dstcap);
+      } catch (const std::bad_alloc&) {
+        items[i].result = LICO_ERROR_MEMORY;
+      }
+    }
+  }
+
+  int result = 0;
+  for (int i = 0; (i < count) && (result == 0); i++) {
+    if (items[i].result < 0) result = items[i].result;
+  }
+  return result;
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_decompress_tensor(const void* const src, const int srcsize, void* const dst, const int dstcap, const lico_tensor* const tensor)
+{
+  LICO_DCtx ctx;
+  return lico_decompress_tensor_dctx(&ctx, src, srcsize, dst, dstcap, tensor);
+}
+
+
+int lico_decompress_tensor_dctx(LICO_DCtx* const dctx, const void* const src, const int srcsize, void* const dst, const int dstcap, const lico_tensor* const tensor)
+try {
+  if ((dctx == nullptr) || (src == nullptr) || (dst == nullptr) || (dstcap < 0) || (tensor == nullptr)) return LICO_ERROR_ARGUMENT;
+  const lico_tensor& t = *tensor;
+  if ((t.layout < LICO_LAYOUT_NHWC) || (t.layout > LICO_LAYOUT_NCHW) || (t.type < LICO_TYPE_UINT) || (t.type > LICO_TYPE_FLOAT) || (t.order < LICO_ORDER_RGB) || (t.order > LICO_ORDER_BGR)) return LICO_ERROR_ARGUMENT;
+  h_config cfg;
+  h_image img;
+  const int res = h_open_image(*dctx, (const byte*)src, srcsize, cfg, img);
+  if (res < 0) return res;
+  const long long bytes = (long long)img.w * img.h * img.C * ((t.type == LICO_TYPE_FLOAT) ? sizeof(float) : img.bytes);
+  if (bytes > dstcap) return LICO_ERROR_CAPACITY;
+
+  // the inverse transform writes every row into the tensor right after rebuilding it
+  const bool planar = (t.layout == LICO_LAYOUT_NCHW);
+  int map [4];
+  h_target_map(img.C, img.bgr, t.order == LICO_ORDER_BGR, map);
+  if (t.type == LICO_TYPE_FLOAT) {
+    h_tensor<float> out = {(float*)dst, img.w, img.h, planar, img.bottomup, {map[0], map[1], map[2], map[3]}, {1.0f, 1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 0.0f}};
+    for (int k = 0; k < 4; k++) {
+      const float std = (t.std[k] == 0) ? 1.0f : t.std[k];
+      out.scale[k] = 1.0f / (img.maxval * std);
+      out.bias[k] = -t.mean[k] / std;
+    }
+    h_iBMP_BIT_image(img, cfg.pred, dctx->temp, out);
+  } else if (img.bytes == 1) {
+    // integer samples are stored as is (scale and bias only apply to floats)
+    const h_tensor<byte> out = {(byte*)dst, img.w, img.h, planar, img.bottomup, {map[0], map[1], map[2], map[3]}, {1.0f, 1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 0.0f}};
+    h_iBMP_BIT_image(img, cfg.pred, dctx->temp, out);
+  } else {
+    const h_tensor<unsigned short> out = {(unsigned short*)dst, img.w, img.h, planar, img.bottomup, {map[0], map[1], map[2], map[3]}, {1.0f, 1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 0.0f}};
+    h_iBMP_BIT_image(img, cfg.pred, dctx->temp, out);
+  }
+  return bytes;
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_decompress_view(const void* const src, const int srcsize, void* const dst, const int dstcap, const lico_view* const view)
+{
+  LICO_DCtx ctx;
+  return lico_decompress_view_dctx(&ctx, src, srcsize, dst, dstcap, view);
+}
+
+
+int lico_decompress_view_dctx(LICO_DCtx* const dctx, const void* const src, const int srcsize, void* const dst, const int dstcap, const lico_view* const view)
+try {
+  if ((dctx == nullptr) || (src == nullptr) || (dst == nullptr) || (dstcap < 0) || (view == nullptr)) return LICO_ERROR_ARGUMENT;
+  const lico_view& v = *view;
+  const int fmt = v.format;
+  if ((h_RAW_BIT_pixel(fmt) == 0) || (v.stride < 0) || (v.stride % h_RAW_bytes[fmt] != 0) || (v.x < 0) || (v.y < 0) || (v.plane < 0)) return LICO_ERROR_ARGUMENT;
+  h_config cfg;
+  h_image img;
+  const int res = h_open_image(*dctx, (const byte*)src, srcsize, cfg, img);
+  if (res < 0) return res;
+  const int D = h_RAW_channels[fmt];
+  h_pixels out = {(byte*)dst, img.w, img.h, 0, 0, v.planar != 0, img.bottomup != (v.flip != 0), D, {-1, -1, -1, -1}, v.alpha};  // stride, plane, and sources are set below
+  const bool bgr = (fmt == LICO_FORMAT_BGR24) || (fmt == LICO_FORMAT_BGRA32) || (fmt == LICO_FORMAT_BGR48);
+  if ((h_RAW_bytes[fmt] != img.bytes) || !h_target_source(img.C, img.bgr, D, bgr, out.src)) return LICO_ERROR_MODE;
+
+  // rows of planar pixels hold one sample per pixel, and the image starts at (x, y) of the canvas
+  const int unit = out.planar ? img.bytes : h_RAW_BIT_pixel(fmt);
+  const long long row = (long long)(v.x + img.w) * unit;
+  out.stride = (v.stride == 0) ? row : v.stride;
+  if (out.stride < row) return LICO_ERROR_ARGUMENT;
+  const long long plane = (v.plane == 0) ? (out.stride * (v.y + img.h)) : v.plane;
+  if (out.planar && (plane < out.stride * (v.y + img.h))) return LICO_ERROR_ARGUMENT;
+  const long long bytes = (out.planar ? ((D - 1) * plane) : 0) + (v.y + img.h - 1) * out.stride + row;
+  if (bytes > dstcap) return LICO_ERROR_CAPACITY;
+  out.dst += v.y * out.stride + (long long)v.x * unit;
+  out.plane = plane;
+  h_iBMP_BIT_image(img, cfg.pred, dctx->temp, out);
+  return bytes;
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+// kinds of independently decodable segments that a reader caches
+enum {h_READ_CHUNK, h_READ_SLAB, h_READ_WHOLE};
+
+
+// decoded segment of a reader: a chunk of untransformed data, a slab of a volume, or the whole image
+struct h_segment
+{
+  byte* data;  // decoded bytes or null
+  long long size;
+  bool busy;  // being decoded
+  int pins;  // reads that are copying from the segment
+  std::list<int>::iterator use;  // position in the LRU list while cached
+};
+
+
+// reader over a mapped file that decodes segments on demand and keeps them in an LRU cache while worker threads prefetch the next ones
+struct LICO_Reader
+{
+  const byte* map;  // mapped file
+  int mapsize;
+  int tsize;  // decoded size
+  h_config cfg;
+  int kind;
+  int rows, width, pixel;  // rows served
+  long long base, pitch;  // position of row 0 and distance between rows in the decoded chunks
+  bool flip;  // rows stored bottom-up
+  bool swap;  // 16-bit samples stored big-endian
+  h_VOL_BIT_info vi;
+  std::vector<int> start;  // chunk index
+  std::vector<h_segment> segs;
+  std::list<int> lru;  // cached segments, most recently used first
+  long long used, budget;  // bytes cached
+  int last, ahead;  // first segment of the previous read and number of segments to prefetch
+  LICO_DCtx dctx;  // decoding of whole images
+  std::mutex lock;
+  std::condition_variable ready;  // a segment has been decoded
+  std::condition_variable work;  // segments were queued or the reader is closing
+  std::deque<int> queue;  // segments to prefetch
+  bool stop;
+  std::vector<std::thread> workers;
+};
+
+
+// decode segment k of a reader into a new buffer (null on failure) and return 0 or an error code (this runs on the prefetch threads, so an
+// allocation failure is returned as LICO_ERROR_MEMORY instead of thrown)
+static int h_reader_load(LICO_Reader& r, const int k, byte*& data, long long& size)
+{
+  const int cs = 1 << r.cfg.csbits;  // chunk size
+  int res = 0;
+  data = nullptr;
+  size = 0;
+  try {
+    if (r.kind == h_READ_CHUNK) {
+      size = std::min(cs, r.tsize - k * cs);
+      data = new byte [size];
+      if (!h_decode_chunk(r.map, r.tsize, r.cfg, r.start.data(), k, data)) res = LICO_ERROR_CORRUPT;
+    } else if (r.kind == h_READ_SLAB) {
+      // decode the chunks that overlap the slab and restore its slices
+      const int beg = h_VOL_BIT_offset(r.vi, k);
+      const int end = h_VOL_BIT_offset(r.vi, k + 1);
+      const int c0 = beg / cs;
+      const int c1 = h_chunk_count(end, cs);
+      size = end - beg;
+      data = new byte [size];
+      const long long csize = (long long)(c1 - c0) * cs;
+      byte* const tmp = new byte [csize + size];  // decoded chunks followed by the scratch space of the inverse transform
+      for (int c = c0; (res == 0) && (c < c1); c++) {
+        if (!h_decode_chunk(r.map, r.tsize, r.cfg, r.start.data(), c, &tmp[(long long)(c - c0) * cs])) res = LICO_ERROR_CORRUPT;
+      }
+      if (res == 0) h_iVOL_BIT_slab(&tmp[beg - c0 * cs], r.vi, k, r.cfg.pred, data, &tmp[csize]);
+      delete [] tmp;
+    } else {
+      size = (long long)r.rows * r.width * r.pixel;
+      data = new byte [size];
+      if (r.cfg.mode == h_MODE_F32) {
+        const int got = lico_decompress_dctx(&r.dctx, r.map, r.mapsize, data, size);
+        if (got != size) res = (got < 0) ? got : LICO_ERROR_CORRUPT;
+      } else {
+        // rebuild the image straight into packed top-down rows with the channels of the image
+        h_config cfg;
+        h_image img;
+        res = h_open_image(r.dctx, r.map, r.mapsize, cfg, img);
+        if ((res == 0) && ((img.w != r.width) || (img.h != r.rows) || (img.C * img.bytes != r.pixel))) res = LICO_ERROR_CORRUPT;
+        if (res == 0) {
+          h_pixels out = {data, img.w, img.h, (long long)r.width * r.pixel, 0, false, img.bottomup, img.C, {0, 1, 2, 3}, 0};
+          h_iBMP_BIT_image(img, cfg.pred, r.dctx.temp, out);
+        }
+      }
+    }
+  } catch (const std::bad_alloc&) {
+    res = LICO_ERROR_MEMORY;
+  }
+  if (res < 0) {
+    delete [] data;
+    data = nullptr;
+  }
+  return res;
+}
+
+
+// cache a decoded segment and return whether it was cached (the lock is held; the data is released if the LRU list cannot grow)
+static bool h_reader_insert(LICO_Reader& r, const int k, byte* const data, const long long size)
+{
+  h_segment& s = r.segs[k];
+  s.busy = false;
+  s.data = nullptr;
+  if (data == nullptr) return false;
+  try {
+    r.lru.push_front(k);
+  } catch (const std::bad_alloc&) {
+    delete [] data;
+    return false;
+  }
+  s.data = data;
+  s.size = size;
+  s.use = r.lru.begin();
+  r.used += size;
+  return true;
+}
+
+
+// drop the least recently used segments that no read is copying from until the cache fits its budget (the lock is held)
+static void h_reader_evict(LICO_Reader& r)
+{
+  auto it = r.lru.end();
+  while ((r.used > r.budget) && (it != r.lru.begin())) {
+    --it;
+    if (it == r.lru.begin()) break;  // the most recently used segment stays even if it exceeds the budget on its own
+    h_segment& s = r.segs[*it];
+    if (s.pins == 0) {
+      delete [] s.data;
+      s.data = nullptr;
+      r.used -= s.size;
+      it = r.lru.erase(it);
+    }
+  }
+}
+
+
+// prefetch queued segments with a single-threaded OpenMP team so that the workers do not oversubscribe the cores
+static void h_reader_work(LICO_Reader* const r)
+{
+#ifdef _OPENMP
+  omp_set_num_threads(1);
+#endif
+  std::unique_lock<std::mutex> guard(r->lock);
+  while (true) {
+    r->work.wait(guard, [r] {return r->stop || !r->queue.empty();});
+    if (r->stop) break;
+    const int k = r->queue.front();
+    r->queue.pop_front();
+    guard.unlock();
+    byte* data;
+    long long size;
+    h_reader_load(*r, k, data, size);
+    guard.lock();
+    h_reader_insert(*r, k, data, size);
+    h_reader_evict(*r);
+    r->ready.notify_all();
+  }
+}
+
+
+// find the rows a file can serve and how they map to segments, returning 0 or an error code
+static int h_reader_init(LICO_Reader& r)
+{
+  if (!h_frame(r.map, r.mapsize, r.tsize, r.cfg)) return LICO_ERROR_CORRUPT;
+  lico_frame_info info;
+  const int res = lico_get_frame_info(r.map, r.mapsize, &info);
+  if (res < 0) return res;
+  const int cs = 1 << r.cfg.csbits;  // chunk size
+  const int chunks = h_chunk_count(r.tsize, cs);
+  r.start.resize(chunks);
+  if (!h_decode_starts(r.map, r.mapsize, r.tsize, r.cfg, r.start.data())) return LICO_ERROR_CORRUPT;
+  std::vector<byte> first(cs);
+  if (!h_decode_chunk(r.map, r.tsize, r.cfg, r.start.data(), 0, first.data())) return LICO_ERROR_CORRUPT;
+  const int fsize = std::min(cs, r.tsize);
+  r.base = 0;
+  r.flip = false;
+  r.swap = false;
+  int segments = 1;
+
+  if (r.cfg.mode == h_MODE_VOL) {
+    // slabs are restored independently
+    if (!h_VOL_BIT_read(first.data(), fsize, r.vi) || (h_BMP_BIT_extent(r.vi.w, r.vi.h, r.vi.d, r.vi.bytes) + h_VOL_BIT_side != r.tsize)) return LICO_ERROR_CORRUPT;
+    r.kind = h_READ_SLAB;
+    r.rows = r.vi.d * r.vi.h;
+    r.width = r.vi.w;
+    r.pixel = r.vi.bytes;
+    segments = (r.vi.d + r.vi.slab - 1) / r.vi.slab;
+  } else if (r.cfg.mode == h_MODE_F32) {
+    r.kind = h_READ_WHOLE;
+    r.rows = info.height;
+    r.width = info.width;
+    r.pixel = sizeof(float);
+    if ((r.rows < 1) || (r.width < 1) || (h_BMP_BIT_extent(r.rows, r.width, r.pixel) != info.size)) return LICO_ERROR_CORRUPT;
+  } else if ((r.cfg.mode != h_MODE_BMP) && (r.cfg.mode != h_MODE_PNM) && (r.cfg.mode != h_MODE_RAW)) {
+    return LICO_ERROR_MODE;
+  } else {
+    r.rows = info.height;
+    r.width = info.width;
+    r.pixel = info.channels * info.bytes;
+    if ((r.rows < 1) || (r.width < 1) || (r.pixel < 1)) return LICO_ERROR_MODE;
+    r.kind = h_READ_WHOLE;
+    if (r.cfg.pred == h_PRED_NONE) {
+      // the pixels of untransformed images sit in the decoded chunks, so each chunk is a segment if the header is in the first chunk
+      h_image img;
+      int w, h, C, maxval, off;
+      if (r.cfg.mode == h_MODE_RAW) {
+        if (!h_RAW_BIT_image(first.data(), r.tsize, false, img)) return LICO_ERROR_CORRUPT;
+        r.kind = h_READ_CHUNK;
+      } else if ((r.cfg.mode == h_MODE_BMP) && (fsize >= 54) && (first[0] == 'B') && (h_BMP_BIT_get4(&first[10]) <= fsize)) {
+        if (!h_BMP_BIT_image(first.data(), r.tsize, false, img)) return LICO_ERROR_MODE;
+        r.kind = h_READ_CHUNK;
+      } else if ((r.cfg.mode == h_MODE_BMP) && (first[0] == 'P') && h_PNM_BIT_fields(first.data(), fsize, w, h, C, maxval, off) && (off <= fsize)) {
+        img.w = w;
+        img.h = h;
+        img.bytes = (maxval < 256) ? 1 : 2;
+        img.width = w * C * img.bytes;
+        if ((long long)h * img.width > r.tsize - off) return LICO_ERROR_CORRUPT;
+        img.pix = &first[off];
+        img.bottomup = false;
+        r.swap = (img.bytes == 2);
+        r.kind = h_READ_CHUNK;
+      }
+      if (r.kind == h_READ_CHUNK) {
+        if ((img.w != r.width) || (img.h != r.rows)) return LICO_ERROR_CORRUPT;
+        r.base = img.pix - first.data();
+        r.pitch = img.width;
+        r.flip = img.bottomup;
+        segments = chunks;
+      }
+    }
+  }
+  if ((long long)r.width * r.pixel > 0x7fffffff) return LICO_ERROR_MODE;
+
+  h_segment empty = {nullptr, 0, false, 0, r.lru.end()};
+  r.segs.assign(segments, empty);
+  return 0;
+}
+
+
+int lico_open_reader(const char* const path, const long long budget, const int threads, LICO_Reader** const reader)
+{
+  if ((path == nullptr) || (budget < 0) || (threads < 0) || (reader == nullptr)) return LICO_ERROR_ARGUMENT;
+  *reader = nullptr;
+
+  // map the file
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) return LICO_ERROR_ARGUMENT;
+  struct stat st;
+  if ((fstat(fd, &st) != 0) || (st.st_size < h_head) || (st.st_size > 0x7fffffff)) {
+    close(fd);
+    return (st.st_size > 0x7fffffff) ? LICO_ERROR_CAPACITY : LICO_ERROR_CORRUPT;
+  }
+  void* const map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return LICO_ERROR_ARGUMENT;
+
+  LICO_Reader* const r = new (std::nothrow) LICO_Reader;
+  if (r == nullptr) {
+    munmap(map, st.st_size);
+    return LICO_ERROR_MEMORY;
+  }
+  r->map = (const byte*)map;
+  r->mapsize = st.st_size;
+  r->used = 0;
+  r->budget = (budget == 0) ? (256LL << 20) : budget;
+  r->last = -1;
+  r->ahead = 2 * threads;
+  r->stop = false;
+  int res;
+  try {
+    res = h_reader_init(*r);
+  } catch (const std::bad_alloc&) {
+    res = LICO_ERROR_MEMORY;
+  }
+  if (res < 0) {
+    munmap(map, st.st_size);
+    delete r;
+    return res;
+  }
+  if (r->kind != h_READ_WHOLE) {
+    try {
+      for (int t = 0; t < threads; t++) r->workers.emplace_back(h_reader_work, r);
+    } catch (...) {
+      // stops the workers that did start
+      lico_close_reader(r);
+      return LICO_ERROR_MEMORY;
+    }
+  }
+  *reader = r;
+  return 0;
+}
+
+
+void lico_close_reader(LICO_Reader* const reader)
+{
+  if (reader == nullptr) return;
+  {
+    std::lock_guard<std::mutex> guard(reader->lock);
+    reader->stop = true;
+  }
+  reader->work.notify_all();
+  for (std::thread& t : reader->workers) t.join();
+  for (h_segment& s : reader->segs) delete [] s.data;
+  munmap((void*)reader->map, reader->mapsize);
+  delete reader;
+}
+
+
+int lico_reader_rows(const LICO_Reader* const reader, int* const rows, int* const width, int* const pixel)
+{
+  if (reader == nullptr) return LICO_ERROR_ARGUMENT;
+  if (rows != nullptr) *rows = reader->rows;
+  if (width != nullptr) *width = reader->width;
+  if (pixel != nullptr) *pixel = reader->pixel;
+  return 0;
+}
+
+
+// segment and offset in it of byte col of row y
+static inline int h_reader_find(const LICO_Reader& r, const int y, const long long col, long long& off)
+{
+  if (r.kind == h_READ_CHUNK) {
+    const int cs = 1 << r.cfg.csbits;  // chunk size
+    const long long pos = r.base + (r.flip ? (r.rows - 1 - y) : y) * r.pitch + col;
+    off = pos % cs;
+    return pos / cs;
+  }
+  const long long rowsize = (long long)r.width * r.pixel;
+  if (r.kind == h_READ_SLAB) {
+    const int z = y / r.vi.h;
+    const int k = z / r.vi.slab;
+    off = ((long long)(z - k * r.vi.slab) * r.vi.h + y % r.vi.h) * rowsize + col;
+    return k;
+  }
+  off = y * rowsize + col;
+  return 0;
+}
+
+
+int lico_read_tile(LICO_Reader* const reader, const int x, const int y, const int width, const int height, void* const dst, const int stride)
+try {
+  if ((reader == nullptr) || (dst == nullptr)) return LICO_ERROR_ARGUMENT;
+  LICO_Reader& r = *reader;
+  if ((x < 0) || (y < 0) || (width < 1) || (height < 1) || (x > r.width - width) || (y > r.rows - height)) return LICO_ERROR_ARGUMENT;
+  const long long len = (long long)width * r.pixel;  // bytes per row of the tile
+  if ((stride < len) || (len * height > 0x7fffffff)) return LICO_ERROR_ARGUMENT;  // the size of the tile must fit the return value
+  const long long col = (long long)x * r.pixel;
+  const int cs = 1 << r.cfg.csbits;  // chunk size
+
+  // segments that hold the rows of the tile
+  std::vector<int> need;
+  for (int j = y; j < y + height; j++) {
+    long long off;
+    const int k = h_reader_find(r, j, col, off);
+    const int n = (r.kind == h_READ_CHUNK) ? (int)((off + len - 1) / cs) : 0;
+    for (int i = 0; i <= n; i++) {
+      if (need.empty() || (need.back() != k + i)) need.push_back(k + i);
+    }
+  }
+  std::sort(need.begin(), need.end());
+  need.erase(std::unique(need.begin(), need.end()), need.end());
+
+  // pin the cached segments and decode the missing ones in parallel; segments that other threads are decoding are waited for and looked at
+  // again, since they may fail or be evicted before they are pinned (the lists are allocated up front so that nothing throws while
+  // segments are pinned or marked busy)
+  const int total = need.size();
+  std::vector<int> held, mine, wait, todo = need;
+  held.reserve(total);
+  mine.reserve(total);
+  wait.reserve(total);
+  std::vector<byte*> data(total);
+  std::vector<long long> size(total);
+  std::vector<int> err(total);
+  int res = 0;
+  std::unique_lock<std::mutex> guard(r.lock);
+  while (!todo.empty() && (res == 0)) {
+    mine.clear();
+    wait.clear();
+    for (const int k : todo) {
+      h_segment& s = r.segs[k];
+      if (s.data != nullptr) {
+        s.pins++;
+        r.lru.splice(r.lru.begin(), r.lru, s.use);
+        held.push_back(k);
+      } else if (s.busy) {
+        wait.push_back(k);
+      } else {
+        s.busy = true;
+        mine.push_back(k);
+      }
+    }
+    guard.unlock();
+    const int num = mine.size();
+    #pragma omp parallel for schedule(dynamic, 1) if (num > 1)
+    for (int i = 0; i < num; i++) {
+      err[i] = h_reader_load(r, mine[i], data[i], size[i]);
+    }
+    guard.lock();
+    for (int i = 0; i < num; i++) {
+      if (!h_reader_insert(r, mine[i], data[i], size[i]) && (err[i] == 0)) err[i] = LICO_ERROR_MEMORY;
+      if (err[i] < 0) {
+        res = err[i];
+      } else {
+        r.segs[mine[i]].pins++;
+        held.push_back(mine[i]);
+      }
+    }
+    r.ready.notify_all();
+    for (const int k : wait) {
+      h_segment& s = r.segs[k];
+      r.ready.wait(guard, [&s] {return !s.busy;});
+    }
+    todo.swap(wait);
+  }
+  guard.unlock();
+
+  // copy the rows
+  if (res == 0) {
+    for (int j = 0; j < height; j++) {
+      byte* const out = &((byte*)dst)[(long long)j * stride];
+      long long off;
+      int k = h_reader_find(r, y + j, col, off);
+      for (long long done = 0; done < len; k++, off = 0) {
+        const long long n = std::min(len - done, r.segs[k].size - off);
+        memcpy(&out[done], &r.segs[k].data[off], n);
+        done += n;
+      }
+      if (r.swap) {
+        for (long long i = 0; i < len; i += 2) std::swap(out[i], out[i + 1]);
+      }
+    }
+  }
+
+  // release the segments and queue the ones that follow in the direction of the reads for prefetching
+  guard.lock();
+  for (const int k : held) r.segs[k].pins--;
+  h_reader_evict(r);
+  if ((res == 0) && !r.workers.empty()) {
+    const bool forward = (need.front() >= r.last);
+    r.last = need.front();
+    const int segments = r.segs.size();
+    long long room = r.budget - r.used;
+    for (int i = 1; i <= r.ahead; i++) {
+      const int k = forward ? (need.back() + i) : (need.front() - i);
+      if ((k < 0) || (k >= segments)) break;
+      h_segment& s = r.segs[k];
+      if ((s.data != nullptr) || s.busy) continue;
+      const long long est = (r.kind == h_READ_CHUNK) ? cs : ((long long)r.vi.slab * r.vi.w * r.vi.h * r.vi.bytes);
+      if (est > room) break;
+      room -= est;
+      try {
+        r.queue.push_back(k);
+      } catch (const std::bad_alloc&) {
+        break;  // prefetching is only a hint
+      }
+      s.busy = true;
+    }
+    r.work.notify_all();
+  }
+  guard.unlock();
+  return (res < 0) ? res : (int)(len * height);
+} catch (const std::bad_alloc&) {
+  return LICO_ERROR_MEMORY;
+}
+
+
+int lico_read_rows(LICO_Reader* const reader, const int first, const int count, void* const dst, const int dstcap)
+{
+  if (reader == nullptr) return LICO_ERROR_ARGUMENT;
+  const long long len = (long long)reader->width * reader->pixel;
+  if ((count < 1) || (dstcap < 0)) return LICO_ERROR_ARGUMENT;
+  if (len * count > dstcap) return LICO_ERROR_CAPACITY;
+  return lico_read_tile(reader, 0, first, reader->width, count, dst, len);
+}
+
+
+// job queued on an executor
+struct LICO_Job
+{
+  LICO_Executor* executor;
+  bool decompress;
+  const void* src;
+  int srcsize;
+  void* dst;
+  int dstcap;
+  lico_params params;
+  lico_callback callback;
+  void* user;
+  int chunks;  // amount of work
+  int result;
+  std::atomic<bool> done;
+};
+
+
+// executor with a dispatcher thread that owns an OpenMP team and one pair of contexts per team thread
+struct LICO_Executor
+{
+  int threads;
+  int fd;  // eventfd signaled on completion or -1
+  LICO_CCtx* cctx;
+  LICO_DCtx* dctx;
+  std::mutex lock;
+  std::condition_variable work;  // jobs were queued or the executor is stopping
+  std::condition_variable finished;  // a job has completed
+  std::deque<LICO_Job*> queue;
+  bool stop;
+  std::thread dispatcher;
+};
+
+
+static inline int h_thread_num()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+
+// run a job with the contexts of thread tid and signal its completion (the job may be released as soon as it is marked done)
+static void h_run(LICO_Executor& ex, LICO_Job* const job, const int tid)
+{
+  const int res = job->decompress ? lico_decompress_dctx(&ex.dctx[tid], job->src, job->srcsize, job->dst, job->dstcap) : lico_compress_cctx(&ex.cctx[tid], job->src, job->srcsize, job->dst, job->dstcap, &job->params);
+  const lico_callback callback = job->callback;
+  void* const user = job->user;
+  {
+    std::lock_guard<std::mutex> guard(ex.lock);
+    job->result = res;
+    job->done.store(true, std::memory_order_release);
+  }
+  ex.finished.notify_all();
+
+  if (ex.fd >= 0) {
+    const unsigned long long one = 1;
+    if (write(ex.fd, &one, sizeof(one)) != sizeof(one)) {}  // only fails if the counter is saturated
+  }
+  if (callback != nullptr) callback(res, user);
+}
+
+
+// take all queued jobs, run the small ones side by side with one thread each and then the large ones with all threads each, and repeat until stopped
+static void h_dispatch(LICO_Executor* const ex)
+{
+#ifdef _OPENMP
+  omp_set_num_threads(ex->threads);
+#endif
+  std::vector<LICO_Job*> small, large;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(ex->lock);
+      ex->work.wait(guard, [ex] {return ex->stop || !ex->queue.empty();});
+      if (ex->queue.empty()) break;
+      for (LICO_Job* const job: ex->queue) {
+        ((job->chunks < 2 * ex->threads) ? small : large).push_back(job);
+      }
+      ex->queue.clear();
+    }
+
+    // the parallel regions inside the library are nested in this one and thus run on the calling thread
+    const int num = small.size();
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < num; i++) {
+      h_run(*ex, small[i], h_thread_num());
+    }
+    for (LICO_Job* const job: large) {
+      h_run(*ex, job, 0);
+    }
+    small.clear();
+    large.clear();
+  }
+}
+
+
+LICO_Executor* lico_create_executor(const int threads)
+{
+#ifdef _OPENMP
+  const int num = (threads > 0) ? threads : omp_get_max_threads();
+#else
+  const int num = 1;
+#endif
+  if (threads < 0) return nullptr;
+  LICO_Executor* const ex = new (std::nothrow) LICO_Executor;
+  if (ex == nullptr) return nullptr;
+  ex->threads = num;
+  ex->cctx = new (std::nothrow) LICO_CCtx [num];
+  ex->dctx = new (std::nothrow) LICO_DCtx [num];
+  ex->stop = false;
+#ifdef __linux__
+  ex->fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#else
+  ex->fd = -1;
+#endif
+  bool started = (ex->cctx != nullptr) && (ex->dctx != nullptr);
+  if (started) {
+    try {
+      ex->dispatcher = std::thread(h_dispatch, ex);
+    } catch (...) {
+      started = false;
+    }
+  }
+  if (!started) {
+    if (ex->fd >= 0) close(ex->fd);
+    delete [] ex->cctx;
+    delete [] ex->dctx;
+    delete ex;
+    return nullptr;
+  }
+  return ex;
+}
+
+
+void lico_free_executor(LICO_Executor* const executor)
+{
+  if (executor == nullptr) return;
+  {
+    std::lock_guard<std::mutex> guard(executor->lock);
+    executor->stop = true;
+  }
+  executor->work.notify_all();
+  executor->dispatcher.join();
+  if (executor->fd >= 0) close(executor->fd);
+  delete [] executor->cctx;
+  delete [] executor->dctx;
+  delete executor;
+}
+
+
+int lico_executor_fd(LICO_Executor* const executor)
+{
+  return (executor == nullptr) ? -1 : executor->fd;
+}
+
+
+// queue a new job
+static LICO_Job* h_submit(LICO_Executor* const ex, const bool decompress, const void* const src, const int srcsize, void* const dst, const int dstcap, const lico_params* const params, const lico_callback callback, void* const user)
+{
+  if (ex == nullptr) return nullptr;
+  LICO_Job* const job = new (std::nothrow) LICO_Job;
+  if (job == nullptr) return nullptr;
+  job->executor = ex;
+  job->decompress = decompress;
+  job->src = src;
+  job->srcsize = srcsize;
+  job->dst = dst;
+  job->dstcap = dstcap;
+  memset(&job->params, 0, sizeof(job->params));
+  if (params != nullptr) job->params = *params;
+  job->callback = callback;
+  job->user = user;
+  job->result = 0;
+  job->done.store(false);
+
+  // estimate the work by the number of chunks
+  int size = srcsize;
+  h_config cfg;
+  int bits = h_levels[h_default_level].csbits;
+  if (decompress) {
+    if (h_frame((const byte*)src, srcsize, size, cfg)) bits = cfg.csbits;
+    else size = 0;
+  } else {
+    lico_params p = job->params;
+    if (p.level == 0) p.level = h_default_level;
+    if ((p.level >= h_min_level) && (p.level <= h_max_level) && (h_chunk_bits(p) >= 0)) bits = h_chunk_bits(p);
+  }
+  job->chunks = (std::max(size, 0) + (1 << bits) - 1) >> bits;
+
+  try {
+    std::lock_guard<std::mutex> guard(ex->lock);
+    ex->queue.push_back(job);
+  } catch (const std::bad_alloc&) {
+    delete job;
+    return nullptr;
+  }
+  ex->work.notify_one();
+  return job;
+}
+
+
+LICO_Job* lico_submit_compress(LICO_Executor* const executor, const void* const src, const int srcsize, void* const dst, const int dstcap, const lico_params* const params, const lico_callback callback, void* const user)
+{
+  return h_submit(executor, false, src, srcsize, dst, dstcap, params, callback, user);
+}
+
+
+LICO_Job* lico_submit_decompress(LICO_Executor* const executor, const void* const src, const int srcsize, void* const dst, const int dstcap, const lico_callback callback, void* const user)
+{
+  return h_submit(executor, true, src, srcsize, dst, dstcap, nullptr, callback, user);
+}
+
+
+int lico_job_done(LICO_Job* const job)
+{
+  return (job != nullptr) && job->done.load(std::memory_order_acquire);
+}
+
+
+int lico_job_wait(LICO_Job* const job)
+{
+  if (job == nullptr) return LICO_ERROR_ARGUMENT;
+  if (!job->done.load(std::memory_order_acquire)) {
+    LICO_Executor* const ex = job->executor;
+    std::unique_lock<std::mutex> guard(ex->lock);
+    ex->finished.wait(guard, [job] {return job->done.load(std::memory_order_acquire);});
+  }
+  const int res = job->result;
+  delete job;
+  return res;
+}
+
+
+const char* lico_error_name(const int code)
+{
+  switch (code) {
+    case LICO_ERROR_ARGUMENT: return "invalid argument";
+    case LICO_ERROR_CAPACITY: return "destination buffer is too small";
+    case LICO_ERROR_CORRUPT: return "compressed data is malformed";
+    case LICO_ERROR_MODE: return "operation is not supported by the compressed data";
+    case LICO_ERROR_MEMORY: return "memory could not be allocated";
+    default: return (code < 0) ? "unknown error" : "no error";
+  }
+}
@@ -0,0 +1,74 @@
+#!/bin/bash
+# This file is part of the LICO project (https://github.com/burtscher/LICO).
+# Checks that LICOdaemon survives corrupt requests and hostile rings and rejects file names over TCP.
+# Usage: test/daemon.sh LICOdaemon LICOclient image.bmp
+
+daemon=$1; client=$2; image=$3
+dir=$(mktemp -d); sock=$dir/lico.sock; port=$((40000 + $$ % 20000))
+fail=0
+check() { if [ "$1" != 0 ]; then echo "FAIL: $2"; fail=1; else echo "ok: $2"; fi; }
+
+"$daemon" "$sock" > /dev/null 2>&1 & unix=$!
+"$daemon" tcp:$port > /dev/null 2>&1 & tcp=$!
+trap 'kill $unix $tcp 2> /dev/null; rm -rf "$dir"' EXIT
+sleep 1
+
+[ "$(stat -c %a "$sock")" = 600 ]; check $? "socket is private to its owner"
+
+for ep in "$sock" tcp:$port; do
+  "$client" $ep c "$image" $dir/a.lico -9 > /dev/null && "$client" $ep d $dir/a.lico $dir/a.bmp > /dev/null && cmp -s "$image" $dir/a.bmp
+  check $? "round trip over $ep"
+
+  # flip bytes after the frame header
+  python3 -c "
+import random, sys
+d = bytearray(open(sys.argv[1], 'rb').read())
+random.seed(1)
+for i in range(200): d[random.randrange(12, len(d))] ^= 0xff
+open(sys.argv[2], 'wb').write(d)" $dir/a.lico $dir/bad.lico
+  ! "$client" $ep d $dir/bad.lico $dir/bad.bmp > /dev/null 2>&1; check $? "corrupt request rejected over $ep"
+
+  "$client" $ep d $dir/a.lico $dir/b.bmp > /dev/null && cmp -s "$image" $dir/b.bmp
+  check $? "daemon still serves over $ep"
+done
+
+# a hand-made path request over TCP must not touch the file system
+python3 -c "
+import socket, struct, sys
+s = socket.create_connection(('127.0.0.1', int(sys.argv[1])))
+names = (sys.argv[2] + '\0' + sys.argv[3] + '\0').encode()
+s.sendall(struct.pack('iii', 1, len(names), 0) + bytes(52) + names)
+sys.exit(0 if struct.unpack('i', s.recv(4))[0] < 0 else 1)" $port "$(realpath "$image")" $dir/leak.lico
+[ $? = 0 ] && [ ! -e $dir/leak.lico ]; check $? "file names rejected over TCP"
+
+"$client" "$sock" c "$image" $dir/s.lico s > /dev/null && "$client" "$sock" d $dir/s.lico $dir/s.bmp s > /dev/null && cmp -s "$image" $dir/s.bmp
+check $? "round trip over shared memory"
+
+# a ring must have a sealed size, and changing its header after it was attached must not move the slots
+python3 -c "
+import fcntl, os, socket, struct, sys, time
+def attach(seal):
+  fd = os.memfd_create('ring', os.MFD_ALLOW_SEALING)
+  os.ftruncate(fd, 64 + 128 + 4096 + 4096)
+  if seal: fcntl.fcntl(fd, fcntl.F_ADD_SEALS, fcntl.F_SEAL_SHRINK | fcntl.F_SEAL_GROW)
+  os.pwrite(fd, struct.pack('iiii', 0x4f43494c, 1, 4096, 4096), 0)
+  s = socket.socket(socket.AF_UNIX)
+  s.connect(sys.argv[1])
+  socket.send_fds(s, [struct.pack('iii', 2, 0, 0) + bytes(52)], [fd])
+  return fd, s, struct.unpack('i', s.recv(4))[0]
+fd, s, res = attach(False)
+if res >= 0: print('unsealed', res); sys.exit(1)
+fd, s, res = attach(True)
+if res != 0: print('sealed', res); sys.exit(1)
+os.pwrite(fd, struct.pack('ii', 1 << 30, 1 << 30), 8)
+os.pwrite(fd, os.urandom(4096), 64 + 128)
+os.pwrite(fd, struct.pack('iii', 0, 1, 4096), 64 + 4)
+os.pwrite(fd, struct.pack('i', 1), 64)
+for i in range(50):
+  if struct.unpack('i', os.pread(fd, 4, 64))[0] == 3: sys.exit(0)
+  time.sleep(0.1)
+print('timeout'); sys.exit(1)" "$sock"
+check $? "rings without sealed size refused and header changes ignored"
+
+kill -0 $unix && kill -0 $tcp; check $? "daemons alive"
+exit $fail